@@ -0,0 +1,94 @@
+#include "arm.hpp"
+#include <iostream>
+
+ArmedConnection::ArmedConnection(HttpConnection& conn, int probe_interval_ms)
+    : conn(conn), probe_interval_ms(probe_interval_ms) {}
+
+void ArmedConnection::record_rtt() {
+    last_rtt = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - probe_start).count();
+    if (best_rtt < 0 || last_rtt < best_rtt) best_rtt = last_rtt;
+}
+
+bool ArmedConnection::probe() {
+    auto request = conn.open("HEAD", "/");
+    probe_start = std::chrono::steady_clock::now();
+    bool ok = request && request->send() && request->receive() && request->status_code() > 0;
+    if (ok) record_rtt();
+    if (!ok) std::cout << "[Arm] Probe failed: " << (request ? request->last_error() : std::string("could not open request")) << std::endl;
+    last_activity = std::chrono::steady_clock::now();
+    return ok;
+}
+
+bool ArmedConnection::arm() {
+    auto t1 = std::chrono::steady_clock::now();
+    armed = conn.preconnect() && probe();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t1).count();
+
+    if (armed) std::cout << "[Arm] Connection to " << conn.host() << " armed in " << ms << "ms, probe RTT " << last_rtt << "ms" << std::endl;
+    return armed;
+}
+
+void ArmedConnection::start_probe() {
+    pending_done = pending_ok = false;
+    in_flight = true;
+    last_activity = probe_start = std::chrono::steady_clock::now();
+
+    // HTTP/2 keeps the socket alive with a PING, no stream and no header block involved
+    if (conn.ping_async([this](bool ok) {
+        pending_ok = ok;
+        pending_done = true;
+        if (ok) record_rtt();
+    })) return;
+
+    pending = conn.open("HEAD", "/");
+    if (!pending || !pending->send()) {
+        pending_done = true;
+        return;
+    }
+    pending->receive_async([this](bool ok) {
+        pending_ok = ok && pending->status_code() > 0;
+        pending_done = true;
+        if (pending_ok) record_rtt();
+    });
+}
+
+void ArmedConnection::reconnect() {
+    auto t1 = std::chrono::steady_clock::now();
+    armed = conn.preconnect() && probe();
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - t1).count();
+    std::cout << "[Arm] " << (armed ? "Reconnected" : "Reconnect failed") << " after " << ms << "ms" << std::endl;
+}
+
+void ArmedConnection::keep_alive(long long ms_remaining) {
+    if (in_flight && pending_done) {
+        bool ok = pending_ok;
+        if (!ok) std::cout << "[Arm] Probe failed: " << (pending ? pending->last_error() : std::string("no PING acknowledgement")) << std::endl;
+        pending.reset();
+        in_flight = false;
+        last_activity = std::chrono::steady_clock::now();
+
+        // A failed probe usually means the server dropped us, reconnect while there is still time
+        if (!ok && ms_remaining > QUIET_MS) reconnect();
+    }
+
+    if (in_flight) {
+        if (ms_remaining > QUIET_MS) return;
+        // An unanswered PING does not hold up a stream, the request can go out next to it
+        if (!pending) return;
+
+        // Still waiting on a slow HEAD at the quiet window. Dropping the request closes the
+        // socket, a fresh (resumed) one is cheaper than firing behind the probe
+        std::cout << "[Arm] Probe unanswered at T-" << ms_remaining << "ms, re-arming." << std::endl;
+        pending.reset();
+        in_flight = false;
+        reconnect();
+        return;
+    }
+
+    if (ms_remaining <= QUIET_MS) return;
+
+    auto idle_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - last_activity).count();
+    if (idle_ms < probe_interval_ms) return;
+
+    start_probe();
+}
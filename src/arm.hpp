@@ -0,0 +1,50 @@
+#pragma once
+#include <chrono>
+#include <memory>
+#include "transport.hpp"
+
+// Keeps the registration connection negotiated and alive during the last seconds before T0,
+// so the fire step writes onto a hot socket instead of paying DNS + TCP + TLS setup
+class ArmedConnection {
+private:
+    HttpConnection& conn;
+    int probe_interval_ms;
+    bool armed = false;
+    std::chrono::steady_clock::time_point last_activity;
+
+    // Keep-alive probe in flight (a PING, or a HEAD request in pending), answered through HttpTransport::poll()
+    std::unique_ptr<HttpRequest> pending;
+    bool in_flight = false;
+    bool pending_done = false;
+    bool pending_ok = false;
+    std::chrono::steady_clock::time_point probe_start;
+
+    // Write to first response byte of the probes, the fire lead time is derived from it
+    double best_rtt = -1;
+    double last_rtt = -1;
+    void record_rtt();
+
+    bool probe();
+    void start_probe();
+    void reconnect();
+
+public:
+    static const int QUIET_MS = 1500; // No probes this close to T0, the socket must be idle when we fire
+
+    ArmedConnection(HttpConnection& conn, int probe_interval_ms);
+
+    // Opens the TCP + TLS session and validates it with one round trip
+    bool arm();
+
+    // Sends a probe (HTTP/2 PING, HEAD otherwise) if the socket has been idle longer than the
+    // probe interval, without waiting for the answer. A HEAD still unanswered at QUIET_MS is
+    // dropped together with its socket and the connection is re-armed, so the fire request
+    // never queues behind it
+    void keep_alive(long long ms_remaining);
+
+    bool is_armed() const { return armed; }
+
+    // Lowest and latest probe round trip on this connection in ms, -1 before the first answer
+    double best_rtt_ms() const { return best_rtt; }
+    double last_rtt_ms() const { return last_rtt; }
+};
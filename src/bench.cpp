@@ -0,0 +1,616 @@
+#include "bench.hpp"
+#include "clock.hpp"
+#include "form_scanner.hpp"
+#include "httpdate.hpp"
+#include "memory.hpp"
+#include "report.hpp"
+#include "realtime.hpp"
+#include "transport.hpp"
+#include "urlform.hpp"
+#include "wake.hpp"
+#include <algorithm>
+#include <cmath>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <locale>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// --- INTERNAL HELPERS ---
+
+static const int ROUNDS = 2000;
+static const size_t CHUNK = 16384; // One TLS record, also the usual WinHTTP chunk
+
+// __VIEWSTATE of girisv3: base64 of a serialized control tree, about 24 KB. Random bytes give
+// the same mix of letters, digits, '+' and '/' (every one of which the form encoder escapes)
+static std::string sample_viewstate() {
+    static const char B64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::mt19937 rng(24576);
+    std::string vs;
+    while (vs.size() < 24 * 1024) vs += B64[rng() % 64];
+    return vs + "==";
+}
+
+// Login page of girisv3: ASP.NET form with a large __VIEWSTATE, roughly the size of the real one
+static std::string sample_login_html() {
+    std::string vs = sample_viewstate();
+
+    std::string html = "<!DOCTYPE html><html><head><title>İTÜ Giriş</title></head><body>"
+                       "<form method=\"post\" action=\"./Login.aspx?subSessionId=5d1e&amp;currentURL=%2f\" id=\"form1\">"
+                       "<input type=\"hidden\" name=\"__VIEWSTATE\" id=\"__VIEWSTATE\" value=\"" + vs + "\" />"
+                       "<input type=\"hidden\" name=\"__VIEWSTATEGENERATOR\" id=\"__VIEWSTATEGENERATOR\" value=\"C2EE9ABB\" />"
+                       "<input type=\"hidden\" name=\"__EVENTVALIDATION\" id=\"__EVENTVALIDATION\" value=\"" + vs.substr(0, 2048) + "\" />";
+    while (html.size() < 48 * 1024) html += "<div class=\"form-group\"><label>Kullanıcı Adı / Username</label></div>\n";
+    return html + "</form></body></html>";
+}
+
+// Registration answer for a full 12 CRN request
+static std::string sample_register_json() {
+    std::string json = "{\"ecrnResultList\":[";
+    for (int i = 0; i < 12; i++) {
+        if (i) json += ",";
+        json += "{\"crn\":\"2" + std::to_string(1000 + i) + "\",\"operationFinished\":true,\"statusCode\":0,"
+                "\"resultCode\":\"VAL06\",\"resultData\":null}";
+    }
+    return json + "],\"scrnResultList\":[]}";
+}
+
+struct BenchResult {
+    double allocs = 0;
+    double us = 0;
+};
+
+// Previous reader: fresh std::vector per chunk, appended into a new std::string per response
+static BenchResult bench_legacy(const std::string& payload) {
+    size_t sink = 0;
+    unsigned long long a0 = allocation_count();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        std::string body;
+        for (size_t pos = 0; pos < payload.size(); pos += CHUNK) {
+            size_t n = std::min(CHUNK, payload.size() - pos);
+            std::vector<char> buffer(n);
+            std::memcpy(buffer.data(), payload.data() + pos, n);
+            body.append(buffer.data(), n);
+        }
+        sink += body.size();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    unsigned long long a1 = allocation_count();
+    if (sink != payload.size() * ROUNDS) std::cerr << "[Bench] Legacy reader lost bytes." << std::endl;
+    return {(double)(a1 - a0) / ROUNDS, std::chrono::duration<double, std::micro>(t1 - t0).count() / ROUNDS};
+}
+
+// Current reader: chunks land directly in one ResponseBuffer reused across responses
+static BenchResult bench_arena(const std::string& payload, ResponseBuffer& arena) {
+    size_t sink = 0;
+    unsigned long long g0 = arena.growth_count();
+    unsigned long long a0 = allocation_count();
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        arena.clear();
+        for (size_t pos = 0; pos < payload.size(); pos += CHUNK) {
+            size_t n = std::min(CHUNK, payload.size() - pos);
+            char* dst = arena.prepare(n);
+            if (!dst) break;
+            std::memcpy(dst, payload.data() + pos, n);
+            arena.commit(n);
+        }
+        sink += arena.view().size();
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    unsigned long long allocs = allocation_count() - a0 + arena.growth_count() - g0;
+    if (sink != payload.size() * ROUNDS) std::cerr << "[Bench] Arena reader lost bytes." << std::endl;
+    return {(double)allocs / ROUNDS, std::chrono::duration<double, std::micro>(t1 - t0).count() / ROUNDS};
+}
+
+// --- READER BENCHMARK ---
+
+void run_reader_bench() {
+    struct Payload {
+        const char* name;
+        std::string body;
+    };
+    Payload payloads[] = {{"login html", sample_login_html()}, {"register json", sample_register_json()}};
+
+    // Same arena for both payloads, the way TokenFetcher reads the whole login chain into one
+    ResponseBuffer arena;
+
+    std::cout << "[Bench] Response reader, " << ROUNDS << " responses per payload, " << CHUNK << " byte chunks" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (const Payload& p : payloads) {
+        BenchResult legacy = bench_legacy(p.body);
+        BenchResult arena_res = bench_arena(p.body, arena);
+        std::cout << "[Bench] " << std::left << std::setw(14) << p.name << std::right << std::setw(7) << p.body.size() << " B"
+                  << " | legacy: " << std::setw(6) << legacy.allocs << " allocs " << std::setw(8) << legacy.us << " us"
+                  << " | arena: " << std::setw(6) << arena_res.allocs << " allocs " << std::setw(8) << arena_res.us << " us"
+                  << std::endl;
+    }
+}
+
+// --- FORM BENCHMARK ---
+
+// Field extraction as TokenFetcher did it before FormScanner: one find per field over the whole page
+static std::string extract_value_legacy(std::string_view html, const std::string& name) {
+    std::string search_str = "id=\"" + name + "\" value=\"";
+    size_t start = html.find(search_str);
+    if (start == std::string::npos) return "";
+    start += search_str.length();
+    size_t end = html.find("\"", start);
+    return std::string(html.substr(start, end - start));
+}
+
+void run_form_bench() {
+    const std::string page = sample_login_html();
+    const char* ids[] = {"__VIEWSTATE", "__VIEWSTATEGENERATOR", "__EVENTVALIDATION"};
+    size_t sink = 0;
+
+    // Old way: the whole page is read first, then searched once per field and for the action
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < ROUNDS; i++) {
+        for (const char* id : ids) sink += extract_value_legacy(page, id).size();
+        sink += page.find("action=\"");
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    // Scanner fed one chunk at a time, stopping as soon as the form is complete
+    size_t needed = 0;
+    bool agree = true;
+    for (int i = 0; i < ROUNDS; i++) {
+        FormScanner form({ids[0], ids[1], ids[2]});
+        size_t have = 0;
+        while (have < page.size() && !form.complete()) {
+            have = std::min(page.size(), have + CHUNK);
+            form.scan(std::string_view(page.data(), have));
+        }
+        needed = have;
+        for (size_t f = 0; f < 3; f++) {
+            std::string_view v = form.value(page, f);
+            sink += v.size();
+            if (i == 0 && v != extract_value_legacy(page, ids[f])) agree = false;
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double legacy_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / ROUNDS;
+    double scan_us = std::chrono::duration<double, std::micro>(t2 - t1).count() / ROUNDS;
+    std::cout << std::fixed << std::setprecision(2)
+              << "[Bench] Login form, " << page.size() << " B page | find: " << legacy_us << " us after "
+              << page.size() << " B | scanner: " << scan_us << " us, complete after " << needed << " B"
+              << (agree ? "" : " (VALUES DIFFER)") << (sink == 0 ? " (empty)" : "") << std::defaultfloat << std::endl;
+}
+
+// --- URL FORM BENCHMARK ---
+
+static const int FORM_ROUNDS = 500;
+
+// TokenFetcher::url_encode before urlform: one stream insertion per byte
+static std::string url_encode_legacy(const std::string& value) {
+    std::ostringstream escaped;
+    escaped.fill('0');
+    escaped << std::hex;
+    for (char c : value) {
+        if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
+            escaped << c;
+        } else {
+            escaped << '%' << std::uppercase << (int)(unsigned char)c;
+        }
+    }
+    return escaped.str();
+}
+
+void run_urlform_bench() {
+    std::mt19937_64 rng(20260301);
+
+    // Properties: same output as the old encoder, and decode(encode(x)) == x, on random byte
+    // strings (every byte value, lengths around the unrolled step) and on real size ViewStates
+    int differ = 0, lost = 0;
+    std::vector<std::string> inputs = {"", "Giriş / Login", "a+b=c&d", sample_viewstate()};
+    for (int i = 0; i < 5000; i++) {
+        std::string s(rng() % 70, '\0');
+        // Mostly unreserved bytes so runs of every length show up, with some of everything else
+        for (char& c : s) c = rng() % 4 ? "abcXYZ019-_.~"[rng() % 13] : (char)(rng() % 256);
+        inputs.push_back(s);
+    }
+    for (const std::string& in : inputs) {
+        std::string enc = url_encode(in);
+        // The old encoder had no setw: bytes below 0x10 came out as one hex digit ("%F"), which
+        // no server reads back. Those inputs are only checked by the round trip
+        bool low = std::any_of(in.begin(), in.end(), [](char c) { return (unsigned char)c < 0x10; });
+        if (!low && enc != url_encode_legacy(in) && differ++ < 5) std::cerr << "[Bench] Encoder differs on [" << in << "]" << std::endl;
+        std::string dec;
+        if ((!url_decode(enc, dec) || dec != in) && lost++ < 5) std::cerr << "[Bench] Round trip lost [" << in << "]" << std::endl;
+    }
+
+    // Broken escapes are rejected, '+' is a space, lower case hex is read
+    std::string out = "kept";
+    bool strict = !url_decode("%", out) && !url_decode("ab%4", out) && !url_decode("%G1", out) && out == "kept";
+    std::string plus;
+    strict = strict && url_decode("a+b%2fc%2F", plus) && plus == "a b/c/";
+
+    const std::string vs = sample_viewstate();
+    size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < FORM_ROUNDS; i++) sink += url_encode_legacy(vs).size();
+    auto t1 = std::chrono::steady_clock::now();
+    std::string body;
+    for (int i = 0; i < FORM_ROUNDS; i++) {
+        body.clear();
+        append_form_field(body, "__VIEWSTATE", vs);
+        sink += body.size();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::string decoded;
+    for (int i = 0; i < FORM_ROUNDS; i++) {
+        decoded.clear();
+        url_decode(body, decoded);
+        sink += decoded.size();
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto us = [](std::chrono::steady_clock::duration d) { return std::chrono::duration<double, std::micro>(d).count() / FORM_ROUNDS; };
+    std::cout << std::fixed << std::setprecision(2)
+              << "[Bench] URL form, " << inputs.size() << " inputs: " << differ << " differ from the old encoder, "
+              << lost << " lost in a round trip, broken escapes " << (strict ? "rejected" : "ACCEPTED") << std::endl
+              << "[Bench] " << vs.size() << " B ViewState | ostringstream: " << us(t1 - t0) << " us | table: "
+              << us(t2 - t1) << " us | decode: " << us(t3 - t2) << " us" << (sink == 0 ? " (empty)" : "")
+              << std::defaultfloat << std::endl;
+}
+
+// --- WAKE BENCHMARK ---
+
+static const int WAKE_ROUNDS = 60;
+
+// Previous wait loop: whole-millisecond remaining time, 10ms sleeps above 50ms, bare spin below
+static double wait_legacy(double deadline) {
+    while (true) {
+        long long remaining = (long long)(deadline - SystemClock::local_ms());
+        if (remaining <= 0) break;
+        if (remaining > 50) std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return (SystemClock::local_ms() - deadline) * 1000.0;
+}
+
+static void print_wake_row(const char* name, const std::vector<double>& errors_us) {
+    std::vector<double> abs_us;
+    for (double e : errors_us) abs_us.push_back(std::fabs(e));
+    std::cout << "[Bench] " << std::left << std::setw(8) << name << std::right
+              << " | |error| p50 " << std::setw(8) << WakeEngine::percentile(abs_us, 50)
+              << " us, p90 " << std::setw(8) << WakeEngine::percentile(abs_us, 90)
+              << " us, p99 " << std::setw(8) << WakeEngine::percentile(abs_us, 99)
+              << " us, max " << std::setw(8) << WakeEngine::percentile(abs_us, 100)
+              << " us | early " << std::count_if(errors_us.begin(), errors_us.end(), [](double e) { return e < 0; })
+              << "/" << errors_us.size() << std::endl;
+}
+
+void run_wake_bench() {
+    WakeEngine engine;
+    engine.calibrate();
+
+    std::vector<double> legacy, calibrated, realtime;
+    for (int i = 0; i < WAKE_ROUNDS; i++) {
+        // Fractional offsets so the deadline lands anywhere inside a millisecond
+        double ahead = 60 + (i % 7) * 3.7;
+        legacy.push_back(wait_legacy(SystemClock::local_ms() + ahead));
+        calibrated.push_back(engine.wait_until(SystemClock::local_ms() + ahead));
+    }
+
+    // Same engine waits on a real-time thread pinned to the last core
+    RealtimeOptions options;
+    options.cpu = (int)std::thread::hardware_concurrency() - 1;
+    RealtimeThread rt(options);
+    rt.start([&]() {
+        for (int i = 0; i < WAKE_ROUNDS; i++) realtime.push_back(engine.wait_until(SystemClock::local_ms() + 60 + (i % 7) * 3.7));
+    });
+    rt.release();
+    rt.join();
+
+    std::cout << "[Bench] Wake error, " << WAKE_ROUNDS << " waits 60-85 ms ahead, guard "
+              << std::fixed << std::setprecision(1) << engine.guard() * 1000.0 << " us" << std::endl;
+    print_wake_row("legacy", legacy);
+    print_wake_row("engine", calibrated);
+    print_wake_row("realtime", realtime);
+    std::cout << "[Bench] Real-time thread: " << rt.describe() << std::endl;
+    if (!rt.fallback_notes().empty()) std::cout << "[Bench] Fell back: " << rt.fallback_notes() << std::endl;
+    std::cout << std::defaultfloat;
+}
+
+// --- DATE PARSER BENCHMARK ---
+
+static const int DATE_ROUNDS = 200000;
+static const int FUZZ_ROUNDS = 200000;
+
+// Previous parser: imbued istringstream + std::get_time, IMF-fixdate only
+static std::time_t parse_date_legacy(const std::string& date_str) {
+    std::tm tm = {};
+    std::istringstream ss(date_str);
+    ss.imbue(std::locale("C"));
+    ss >> std::get_time(&tm, "%a, %d %b %Y %H:%M:%S");
+    if (ss.fail()) return -1;
+#ifdef _WIN32
+    return _mkgmtime(&tm);
+#else
+    return timegm(&tm);
+#endif
+}
+
+// All three HTTP-date forms of t
+static void format_dates(std::time_t t, std::string out[3]) {
+    static const char* const LONG_DAYS[] = {"Sunday", "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday"};
+    std::tm tm = {};
+#ifdef _WIN32
+    gmtime_s(&tm, &t);
+#else
+    gmtime_r(&t, &tm);
+#endif
+    char buf[64];
+    std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+    out[0] = buf;
+    std::strftime(buf, sizeof(buf), ", %d-%b-%y %H:%M:%S GMT", &tm);
+    out[1] = std::string(LONG_DAYS[tm.tm_wday]) + buf;
+    std::strftime(buf, sizeof(buf), "%a %b %e %H:%M:%S %Y", &tm);
+    out[2] = buf;
+}
+
+void run_date_bench() {
+    std::mt19937_64 rng(20260207);
+    // 1970..2069, the range the two digit RFC 850 year maps onto
+    std::uniform_int_distribution<long long> when(0, 3155759999LL);
+
+    // Known answers: every form of random instants must parse back to the same second
+    int wrong = 0;
+    std::vector<std::string> corpus;
+    for (int i = 0; i < 10000; i++) {
+        std::time_t t = (std::time_t)when(rng);
+        std::string forms[3];
+        format_dates(t, forms);
+        for (const std::string& f : forms) {
+            if (parse_http_date(f) != t) {
+                if (wrong++ < 5) std::cerr << "[Bench] Misparsed [" << f << "] as " << parse_http_date(f) << ", expected " << t << std::endl;
+            }
+            corpus.push_back(f);
+        }
+    }
+
+    // Mutations: byte flips, truncations and splices. Every result must be -1 or a time the
+    // input's own fields spell out, so anything accepted has to survive a format round trip
+    int accepted = 0, inconsistent = 0;
+    std::uniform_int_distribution<size_t> pick(0, corpus.size() - 1);
+    for (int i = 0; i < FUZZ_ROUNDS; i++) {
+        std::string s = corpus[pick(rng)];
+        switch (rng() % 4) {
+            case 0: s[rng() % s.size()] = (char)(rng() % 256); break;
+            case 1: s.resize(rng() % s.size()); break;
+            case 2: s.insert(rng() % (s.size() + 1), 1, (char)(rng() % 256)); break;
+            default: s = s.substr(0, rng() % s.size()) + corpus[pick(rng)].substr(rng() % 20); break;
+        }
+        // Exact size, so a read past the end is caught by sanitizers
+        std::unique_ptr<char[]> exact(new char[s.size()]);
+        std::memcpy(exact.get(), s.data(), s.size());
+        std::time_t t = parse_http_date(std::string_view(exact.get(), s.size()));
+        if (t == -1) continue;
+        accepted++;
+        std::string forms[3];
+        format_dates(t, forms);
+        // Leap seconds roll over into the next minute, nothing to compare against
+        if (s.find(":60") != std::string::npos) continue;
+        if (t < 0) continue; // strftime does not pad years before 1000
+        // The weekday is not checked against the date, compare what follows it. Trailing
+        // whitespace and a zero padded asctime day are accepted as well
+        auto fields = [](std::string d) {
+            while (!d.empty() && (d.back() == ' ' || d.back() == '\t')) d.pop_back();
+            while (!d.empty() && (d.front() == ' ' || d.front() == '\t')) d.erase(0, 1);
+            size_t pad = d.find("  ");
+            if (d.find(',') == std::string::npos && pad != std::string::npos) d.replace(pad, 2, " 0");
+            return d.substr(std::min(d.find(' '), d.size()));
+        };
+        if (fields(s) != fields(forms[0]) && fields(s) != fields(forms[1]) && fields(s) != fields(forms[2])) {
+            if (inconsistent++ < 10) std::cerr << "[Bench] Accepted [" << s << "] as " << forms[0] << std::endl;
+        }
+    }
+
+    std::string imf = corpus[0];
+    std::time_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < DATE_ROUNDS / 10; i++) sink += parse_date_legacy(imf);
+    auto t1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < DATE_ROUNDS; i++) sink += parse_http_date(imf);
+    auto t2 = std::chrono::steady_clock::now();
+    unsigned long long a0 = allocation_count();
+    for (int i = 0; i < 1000; i++) sink += parse_http_date(imf);
+    unsigned long long allocs = allocation_count() - a0;
+
+    double legacy_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / (DATE_ROUNDS / 10);
+    double fast_ns = std::chrono::duration<double, std::nano>(t2 - t1).count() / DATE_ROUNDS;
+    std::cout << std::fixed << std::setprecision(1)
+              << "[Bench] Date parser, " << corpus.size() << " known dates: " << wrong << " wrong | "
+              << FUZZ_ROUNDS << " mutations: " << accepted << " accepted, " << inconsistent << " inconsistent" << std::endl
+              << "[Bench] get_time: " << legacy_ns << " ns/date | parse_http_date: " << fast_ns << " ns/date, "
+              << allocs << " allocs (" << (sink == 0 ? "" : "ok") << ")" << std::defaultfloat << std::endl;
+}
+
+// --- TLS RESUMPTION BENCHMARK ---
+
+static const int TLS_ROUNDS = 50;
+
+#ifdef __linux__
+// Self-signed P-256 certificate for "localhost", good for a day
+static bool make_certificate(EVP_PKEY*& key, X509*& cert) {
+    key = EVP_EC_gen("P-256");
+    cert = X509_new();
+    if (!key || !cert) return false;
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 86400);
+    X509_set_pubkey(cert, key);
+    X509_NAME* name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+
+    X509V3_CTX v3;
+    X509V3_set_ctx_nodb(&v3);
+    X509V3_set_ctx(&v3, cert, cert, nullptr, nullptr, 0);
+    X509_EXTENSION* san = X509V3_EXT_conf_nid(nullptr, &v3, NID_subject_alt_name, "DNS:localhost");
+    if (!san) return false;
+    X509_add_ext(cert, san, -1);
+    X509_EXTENSION_free(san);
+    return X509_sign(cert, key, EVP_sha256()) > 0;
+}
+
+// Answers every request on 127.0.0.1:port with an empty 200, one connection at a time, until
+// stopped. Without tickets every handshake is a full one
+class LoopbackTlsServer {
+private:
+    SSL_CTX* ctx;
+    int fd;
+    int port = 0;
+    std::thread worker;
+
+    void serve() {
+        while (true) {
+            int client = ::accept(fd, nullptr, nullptr);
+            if (client < 0) return; // Listening socket shut down
+            SSL* ssl = SSL_new(ctx);
+            SSL_set_fd(ssl, client);
+            if (SSL_accept(ssl) == 1) {
+                std::string in;
+                char buf[4096];
+                int n;
+                while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+                    in.append(buf, (size_t)n);
+                    if (in.find("\r\n\r\n") == std::string::npos) continue;
+                    in.clear();
+                    static const char OK[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+                    SSL_write(ssl, OK, sizeof(OK) - 1);
+                }
+                SSL_shutdown(ssl);
+            }
+            SSL_free(ssl);
+            ::close(client);
+        }
+    }
+
+public:
+    LoopbackTlsServer(EVP_PKEY* key, X509* cert, bool tickets) : ctx(SSL_CTX_new(TLS_server_method())) {
+        SSL_CTX_use_certificate(ctx, cert);
+        SSL_CTX_use_PrivateKey(ctx, key);
+        if (!tickets) {
+            SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+            SSL_CTX_set_num_tickets(ctx, 0);
+            SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_OFF);
+        }
+
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (fd >= 0 && ::bind(fd, (sockaddr*)&addr, len) == 0 && ::listen(fd, 8) == 0 &&
+            ::getsockname(fd, (sockaddr*)&addr, &len) == 0) {
+            port = ntohs(addr.sin_port);
+            worker = std::thread([this]() { serve(); });
+        }
+    }
+
+    ~LoopbackTlsServer() {
+        if (fd >= 0) {
+            ::shutdown(fd, SHUT_RDWR);
+            if (worker.joinable()) worker.join();
+            ::close(fd);
+        }
+        SSL_CTX_free(ctx);
+    }
+
+    int get_port() const { return port; }
+};
+
+// Connects TLS_ROUNDS + 1 times and returns the handshake times after the first one, which is
+// always full. The HEAD on each connection reads the session ticket the server sends
+static std::vector<double> time_handshakes(HttpTransport& transport, int port) {
+    std::vector<double> ms;
+    for (int i = 0; i <= TLS_ROUNDS; i++) {
+        auto conn = transport.connect("localhost", port);
+        auto t0 = std::chrono::steady_clock::now();
+        if (!conn->preconnect()) break;
+        double took = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        if (i > 0) ms.push_back(took);
+        auto request = conn->open("HEAD", "/");
+        if (!request->send() || !request->receive()) break;
+    }
+    return ms;
+}
+#endif
+
+void run_tls_bench() {
+#ifdef __linux__
+    EVP_PKEY* key = nullptr;
+    X509* cert = nullptr;
+    if (!make_certificate(key, cert)) {
+        std::cerr << "[Bench] TLS: could not create the test certificate." << std::endl;
+        EVP_PKEY_free(key);
+        X509_free(cert);
+        return;
+    }
+    BIO* bio = BIO_new(BIO_s_mem());
+    PEM_write_bio_X509(bio, cert);
+    char* pem = nullptr;
+    long pem_len = BIO_get_mem_data(bio, &pem);
+
+    TransportOptions options;
+    options.http2 = false; // The loopback server only speaks HTTP/1.1
+    options.extra_ca_pem.assign(pem, (size_t)pem_len);
+    BIO_free(bio);
+
+    std::vector<double> full, resumed;
+    RunReport report;
+    {
+        LoopbackTlsServer plain(key, cert, false), ticketed(key, cert, true);
+        auto transport = make_transport("linux", "bench", options);
+
+        // Every reconnect logs a line, the rows below say it once
+        std::ostringstream muted;
+        std::streambuf* console = std::cout.rdbuf(muted.rdbuf());
+        if (plain.get_port() && ticketed.get_port()) {
+            full = time_handshakes(*transport, plain.get_port());
+            resumed = time_handshakes(*transport, ticketed.get_port());
+        }
+        std::cout.rdbuf(console);
+        transport->fill_report(report);
+    }
+    EVP_PKEY_free(key);
+    X509_free(cert);
+
+    int reused = 0;
+    for (const auto& [host, stats] : report.section("tls").items()) {
+        if (host.find("localhost:") == 0) reused += stats.value("resumed", 0);
+    }
+    auto row = [](const char* name, const std::vector<double>& ms) {
+        std::cout << "[Bench] " << std::left << std::setw(8) << name << std::right
+                  << " | p50 " << std::setw(6) << WakeEngine::percentile(ms, 50)
+                  << " ms, p90 " << std::setw(6) << WakeEngine::percentile(ms, 90)
+                  << " ms, max " << std::setw(6) << WakeEngine::percentile(ms, 100) << " ms" << std::endl;
+    };
+    std::cout << std::fixed << std::setprecision(3) << "[Bench] TLS handshake to loopback, " << full.size() << " + "
+              << resumed.size() << " reconnects, " << reused << " resumed" << std::endl;
+    row("full", full);
+    row("resumed", resumed);
+    std::cout << std::defaultfloat;
+#else
+    std::cout << "[Bench] TLS resumption benchmark needs the Linux transport, skipped." << std::endl;
+#endif
+}
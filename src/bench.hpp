@@ -0,0 +1,32 @@
+#pragma once
+
+// Offline microbenchmarks, started with -bench. They need no network and no config.
+
+// Reads typical login HTML and registration JSON bodies chunk by chunk, once the old way
+// (a fresh buffer per chunk appended to a growing string) and once through a reused
+// ResponseBuffer, and prints heap allocations and time per response for both
+void run_reader_bench();
+
+// Extracts the hidden fields of the sample login page, once with a find per field over the
+// whole page and once with FormScanner fed 16 KB chunks, and prints the time and the bytes
+// each needed before the POST could go out
+void run_form_bench();
+
+// Checks the table-driven form encoder against the old ostringstream one and decode(encode(x))
+// against x on random byte strings and a real size ViewState, then times encoding and decoding
+void run_urlform_bench();
+
+// Waits for deadlines 60-85 ms ahead, once with the old loop (10 ms sleeps, whole-millisecond
+// check, bare spin), with the calibrated WakeEngine, and with the engine on a RealtimeThread,
+// and prints the wake error percentiles of each
+void run_wake_bench();
+
+// Checks parse_http_date against known dates in all three forms and against random mutations
+// of them (must never read out of bounds, must reject what timegm would not accept), then
+// times it against the previous istringstream/get_time parser
+void run_date_bench();
+
+// Starts a loopback TLS server with a throwaway certificate and connects to it through the
+// transport, once without session tickets and once with them, and prints the full and resumed
+// handshake times (TCP connect included). Linux only
+void run_tls_bench();
@@ -1,103 +1,518 @@
 #include "clock.hpp"
+#include "httpdate.hpp"
+#include "report.hpp"
+#include "wake.hpp"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
-#include <sstream>
 #include <thread>
 #include <vector>
+#ifdef __linux__
+#include <time.h>
+#endif
 
 SystemClock::SystemClock() : offset_ms(0) {}
 
-const int samples = 5; // Take the average of n probes to filter out jitter 
+SystemClock::~SystemClock() {
+    stop_discipline();
+}
+
+static double epoch_ms(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration<double, std::milli>(tp.time_since_epoch()).count();
+}
+
+// Raw oscillator time: never stepped, and on Linux not slewed by NTP either
+static double raw_ms() {
+#ifdef __linux__
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+#else
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+double SystemClock::local_ms() {
+    // Anchored to the wall clock once, so local times and offsets still read like epoch ms
+    static const double anchor = epoch_ms(std::chrono::system_clock::now()) - raw_ms();
+    return raw_ms() + anchor;
+}
+
+static const size_t MAX_FIXES = 32;         // Sliding window of the drift fit
+static const double MIN_DRIFT_SPAN_MS = 30000; // Below this the fit only estimates the offset
+static const double MAX_DRIFT = 500e-6;       // Anything steeper is a clock step, not drift
+static const int TRACK_PROBES = 6;
+static const double PROBE_TIMEOUT_MS = 3000; // Lane probes still unanswered this long after their send time are dropped
+
+// Samples slower than this are mostly queueing delay: their bound is wide and, when a proxy or
+// a busy backend answered, not trustworthy
+static bool low_rtt(double rtt, double best) {
+    return rtt <= std::max(best * 2, best + 5);
+}
+
+bool SystemClock::probe(HttpConnection& conn, Sample& out) {
+    auto request = conn.open("HEAD", "/");
+    out.t1 = local_ms();
+    if (!request || !request->send() || !request->receive()) return false;
+    out.t2 = local_ms();
+    return finish_probe(*request, out);
+}
+
+bool SystemClock::finish_probe(HttpRequest& request, Sample& out) {
+    out.date = request.query_header("Date");
+    out.server_s = parse_http_date(out.date);
+    if (out.server_s <= 0) return false;
+
+    double server_ms = (double)out.server_s * 1000.0;
+    out.rtt_ms = out.t2 - out.t1;
+    out.lo = server_ms - out.t2;
+    out.hi = server_ms + 1000.0 - out.t1;
+    return true;
+}
+
+void SystemClock::probe_at(HttpConnection* single, const std::vector<double>& send_at, std::vector<Sample>& out) {
+    if (single) {
+        for (double at : send_at) {
+            WakeEngine::sleep_until(at);
+            Sample p;
+            if (probe(*single, p)) out.push_back(p);
+        }
+        return;
+    }
+
+    struct Slot {
+        std::unique_ptr<HttpRequest> request;
+        Sample sample;
+        bool sent = false, done = false, ok = false;
+    };
+    std::vector<Slot> slots(std::min(send_at.size(), probe_conns.size()));
+    size_t open = slots.size();
+    double give_up = *std::max_element(send_at.begin(), send_at.begin() + slots.size()) + PROBE_TIMEOUT_MS;
+
+    // Sends each probe when its time comes and collects the answers in between. The receive
+    // time is taken in the completion callback, not when this loop gets around to it
+    while (open > 0 && local_ms() < give_up) {
+        double now = local_ms();
+        double next = give_up;
+        for (size_t i = 0; i < slots.size(); i++) {
+            Slot& s = slots[i];
+            if (s.sent) continue;
+            if (send_at[i] > now) {
+                next = std::min(next, send_at[i]);
+                continue;
+            }
+            s.sent = true;
+            s.request = probe_conns[i]->open("HEAD", "/");
+            s.sample.t1 = local_ms();
+            if (!s.request || !s.request->send()) {
+                s.done = true;
+                open--;
+                continue;
+            }
+            s.request->receive_async([&s, &open](bool ok) {
+                s.sample.t2 = local_ms();
+                s.ok = ok;
+                s.done = true;
+                open--;
+            });
+        }
+        if (open > 0) probe_lane->poll((int)std::max(0.0, std::floor(next - local_ms())));
+    }
+
+    for (Slot& s : slots) {
+        if (s.done && s.ok && finish_probe(*s.request, s.sample)) out.push_back(s.sample);
+    }
+}
+
+void SystemClock::estimate() {
+    bounded = false;
+    agreeing = 0;
+    if (history.empty()) return;
+
+    best_rtt_ms = history[0].rtt_ms;
+    for (const Sample& s : history) best_rtt_ms = std::min(best_rtt_ms, s.rtt_ms);
 
-std::time_t SystemClock::parse_http_date(const std::wstring& date_str) {
-    std::tm tm = {};
-    std::wistringstream ss(date_str);
-    // Format example: Sat, 07 Feb 2026 14:00:01 GMT
-    // Note: Windows implementation of get_time can be locale-sensitive.
-    // For robustness in this specific format, simple parsing is often safer, 
-    // but get_time works if locale is "C".
-    ss.imbue(std::locale("C")); 
-    ss >> std::get_time(&tm, L"%a, %d %b %Y %H:%M:%S");
-    return _mkgmtime(&tm);
+    // Marzullo's algorithm over the low-RTT samples: the interval most of them agree on. A
+    // sample that does not contain it (stale cache, backend with its own clock) is an outlier
+    std::vector<std::pair<double, int>> edges;
+    for (Sample& s : history) {
+        s.use = low_rtt(s.rtt_ms, best_rtt_ms) ? Sample::Use::Used : Sample::Use::HighRtt;
+        if (s.use != Sample::Use::Used) continue;
+        edges.push_back({s.lo, +1});
+        edges.push_back({s.hi, -1});
+    }
+    // Bounds are half open, an interval ending where another starts does not overlap it
+    std::sort(edges.begin(), edges.end());
+
+    int count = 0;
+    for (size_t i = 0; i + 1 < edges.size(); i++) {
+        count += edges[i].second;
+        if (count > agreeing) {
+            agreeing = count;
+            bound_lo = edges[i].first;
+            bound_hi = edges[i + 1].first;
+        }
+    }
+    if (agreeing == 0) return;
+    bounded = true;
+
+    for (Sample& s : history) {
+        if (s.use == Sample::Use::Used && (s.lo > bound_lo || s.hi < bound_hi)) s.use = Sample::Use::Outlier;
+    }
+}
+
+void SystemClock::refine_with_edges(HttpConnection* single, int rounds, double seed_lo, double seed_hi) {
+    size_t width = single ? 1 : probe_conns.size();
+    for (int round = 0; round < rounds; round++) {
+        // Nothing left to gain once the bound is as narrow as the round trip itself
+        if (bound_hi - bound_lo <= best_rtt_ms + 1) break;
+
+        // Aim inside the bound, narrowed by the model's prediction while the two agree
+        double lo = bound_lo, hi = bound_hi;
+        if (seed_lo < hi && seed_hi > lo) {
+            lo = std::max(lo, seed_lo);
+            hi = std::min(hi, seed_hi);
+        }
+
+        // Probe k takes the offset to be the middle of the k-th of width equal slices and aims
+        // its midpoint at the next server second edge. Whichever side of the edge each Date
+        // lands on, the bound shrinks to about one slice (half of it for a single probe)
+        double half_rtt = best_rtt_ms / 2;
+        double slice = (hi - lo) / (double)width;
+        double edge = std::ceil((local_ms() + hi + half_rtt + 50) / 1000.0) * 1000.0;
+        std::vector<double> send_at;
+        for (size_t k = 0; k < width; k++) send_at.push_back(edge - (lo + ((double)k + 0.5) * slice) - half_rtt);
+
+        std::vector<Sample> got;
+        probe_at(single, send_at, got);
+        for (Sample& p : got) {
+            p.edge = true;
+            history.push_back(p);
+        }
+        estimate();
+        if (!bounded) return;
+    }
 }
 
-void SystemClock::sync_with_server(HINTERNET hConnect) {
+void SystemClock::print_samples() const {
+    static const char* USE_NAMES[] = {"used", "high rtt", "outlier"};
+
+    std::cout << "[Clock] Samples (offset bound in ms):" << std::endl;
+    std::cout << "     #  Kind       RTT        Low       High  Use" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    for (size_t i = 0; i < history.size(); i++) {
+        const Sample& s = history[i];
+        std::cout << std::setw(6) << (i + 1) << "  " << std::left << std::setw(6) << (s.edge ? "edge" : "coarse") << std::right
+                  << std::setw(8) << s.rtt_ms << std::setw(11) << s.lo << std::setw(11) << s.hi << "  "
+                  << USE_NAMES[(int)s.use] << std::endl;
+    }
+    std::cout << std::defaultfloat;
+}
+
+void SystemClock::set_probe_lane(std::unique_ptr<HttpTransport> transport, const std::string& host, int burst, int port) {
+    probe_conns.clear();
+    probe_lane = std::move(transport);
+    if (!probe_lane) return;
+    for (int i = 0; i < std::max(burst, 1); i++) probe_conns.push_back(probe_lane->connect(host, port));
+}
+
+void SystemClock::sync_with_server(HttpConnection& conn) {
+    run_sync(&conn);
+}
+
+void SystemClock::sync_with_server() {
+    if (probe_conns.empty()) {
+        std::cout << "[Clock] No probe lane, keeping offset " << this->offset_ms << "ms." << std::endl;
+        return;
+    }
+    run_sync(nullptr);
+}
+
+void SystemClock::run_sync(HttpConnection* single) {
     std::cout << "[Clock] Syncing with ITU server..." << std::endl;
+    double started = local_ms();
 
-    long long total_offset = 0;
-
-    for (int i = 0; i < samples; i++) {
-        HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"HEAD", L"/", 
-                                                NULL, WINHTTP_NO_REFERER, 
-                                                WINHTTP_DEFAULT_ACCEPT_TYPES, 
-                                                WINHTTP_FLAG_SECURE);
-        
-        auto t1 = std::chrono::system_clock::now();
-        if (WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0, WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
-            WinHttpReceiveResponse(hRequest, NULL)) {
-            
-            auto t2 = std::chrono::system_clock::now();
-            
-            wchar_t date_buffer[256];
-            DWORD dwSize = sizeof(date_buffer);
-            WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CUSTOM, L"Date", date_buffer, &dwSize, WINHTTP_NO_HEADER_INDEX);
-
-            std::time_t server_time_t = parse_http_date(date_buffer);
-            // Server time is in seconds precision, so we treat it as X.000s
-            // Ideally, we assume the server generated this at the midpoint of our request
-            auto server_time_pt = std::chrono::system_clock::from_time_t(server_time_t);
-            auto mid_point_local = t1 + (t2 - t1) / 2;
-
-            auto diff = std::chrono::duration_cast<std::chrono::milliseconds>(server_time_pt - mid_point_local).count();
-            total_offset += diff;
-            
-            std::wcout << L"   Sample " << (i+1) << ": Server Date [" << date_buffer << L"] Offset: " << diff << "ms" << std::endl;
+    // A resync starts from scratch, the local clock may have been stepped meanwhile. An existing
+    // model only narrows where the edge probes are aimed
+    history.clear();
+    double seed_lo = -1e18, seed_hi = 1e18;
+    double seed_error = -1;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!fixes.empty()) seed_error = fixes.back().error_ms;
+    }
+    if (seed_error >= 0) {
+        double predicted = offset_at(local_ms());
+        double slack = std::max(20.0, 4 * seed_error);
+        seed_lo = predicted - slack;
+        seed_hi = predicted + slack;
+    }
+
+    // Lane connections are negotiated first, a handshake must not end up inside an RTT
+    size_t width = 1;
+    if (!single) {
+        for (auto& conn : probe_conns) conn->preconnect();
+        width = probe_conns.size();
+    }
+
+    // Coarse pass, in rounds of one probe per connection
+    std::vector<Sample> coarse;
+    for (int sent = 0; sent < probe_count;) {
+        size_t n = std::min(width, (size_t)(probe_count - sent));
+        probe_at(single, std::vector<double>(n, local_ms()), coarse);
+        sent += (int)n;
+        if (sent < probe_count) WakeEngine::sleep_until(local_ms() + probe_interval_ms);
+    }
+    for (size_t i = 0; i < coarse.size(); i++) {
+        history.push_back(coarse[i]);
+        std::cout << "   Sample " << (i+1) << ": Server Date [" << coarse[i].date << "] RTT: " << std::fixed << std::setprecision(1)
+                  << coarse[i].rtt_ms << std::defaultfloat << "ms" << std::endl;
+    }
+    estimate();
+
+    if (!bounded) {
+        std::cout << "[Clock] No usable Date header, keeping offset " << this->offset_ms << "ms." << std::endl;
+        return;
+    }
+
+    if (edge_probes > 0) {
+        std::cout << "[Clock] Probing the server's second edge..." << std::endl;
+        // With a model to aim from, one edge is enough: the discipline thread keeps refining
+        refine_with_edges(single, seed_error >= 0 ? 1 : edge_probes, seed_lo, seed_hi);
+    }
+    print_samples();
+
+    this->offset_ms = std::llround((bound_lo + bound_hi) / 2);
+    add_fix(history.back().t2, (bound_lo + bound_hi) / 2, get_error_ms());
+    std::cout << "[Clock] Final Offset: " << this->offset_ms << "ms +/- " << std::fixed << std::setprecision(1) << get_error_ms()
+              << std::defaultfloat << "ms from " << agreeing << "/" << history.size()
+              << " samples (Positive means Local is SLOWER)" << std::endl;
+    std::cout << "[Clock] Sync took " << std::llround(local_ms() - started) << "ms on " << width
+              << (single ? " shared" : " dedicated") << " connection" << (width > 1 ? "s" : "") << "." << std::endl;
+}
+
+void SystemClock::add_fix(double t_ms, double offset, double error) {
+    std::lock_guard<std::mutex> guard(lock);
+    fixes.push_back({t_ms, offset, std::max(error, 0.5)});
+    if (fixes.size() > MAX_FIXES) fixes.erase(fixes.begin());
+
+    // Weighted least squares of offset over time, each fix weighted by 1 / error^2
+    double t0 = fixes.back().t_ms;
+    double sw = 0, st = 0, sy = 0, stt = 0, sty = 0;
+    for (const Fix& f : fixes) {
+        double w = 1.0 / (f.error_ms * f.error_ms);
+        double dt = f.t_ms - t0;
+        sw += w;
+        st += w * dt;
+        sy += w * f.offset_ms;
+        stt += w * dt * dt;
+        sty += w * dt * f.offset_ms;
+    }
+    double base = sy / sw;
+    double drift = 0;
+    double det = sw * stt - st * st;
+    if (fixes.back().t_ms - fixes.front().t_ms >= MIN_DRIFT_SPAN_MS && det > 0) {
+        drift = std::clamp((sw * sty - st * sy) / det, -MAX_DRIFT, MAX_DRIFT);
+        base = (sy - drift * st) / sw;
+    }
+
+    // Odd sequence while the fields are being written, readers retry until it is even again
+    model_seq.fetch_add(1, std::memory_order_acq_rel);
+    model_t0_us.store(std::llround(t0 * 1000), std::memory_order_relaxed);
+    model_offset_us.store(std::llround(base * 1000), std::memory_order_relaxed);
+    model_drift_ppb.store(std::llround(drift * 1e9), std::memory_order_relaxed);
+    model_seq.fetch_add(1, std::memory_order_release);
+}
+
+void SystemClock::read_model(double& t0, double& base, double& drift) const {
+    long long t0_us, base_us, drift_ppb;
+    while (true) {
+        unsigned seq = model_seq.load(std::memory_order_acquire);
+        if (seq & 1) continue;
+        t0_us = model_t0_us.load(std::memory_order_relaxed);
+        base_us = model_offset_us.load(std::memory_order_relaxed);
+        drift_ppb = model_drift_ppb.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (model_seq.load(std::memory_order_relaxed) == seq) break;
+    }
+    t0 = (double)t0_us / 1000.0;
+    base = (double)base_us / 1000.0;
+    drift = (double)drift_ppb * 1e-9;
+}
+
+double SystemClock::offset_at(double local) const {
+    double t0, base, drift;
+    read_model(t0, base, drift);
+    return base + drift * (local - t0);
+}
+
+double SystemClock::deadline_for(double server_ms) const {
+    // Solves local + offset_at(local) = server_ms
+    double t0, base, drift;
+    read_model(t0, base, drift);
+    return (server_ms - base + drift * t0) / (1 + drift);
+}
+
+long long SystemClock::get_offset() const {
+    return std::llround(offset_at(local_ms()));
+}
+
+bool SystemClock::track(HttpConnection& conn) {
+    // Start from the model's prediction with some slack for its error, then bisect as in the full sync
+    double predicted = offset_at(local_ms());
+    double last_error;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        last_error = fixes.empty() ? 500 : fixes.back().error_ms;
+    }
+    double slack = std::max(20.0, 4 * last_error);
+    double lo = predicted - slack, hi = predicted + slack;
+    double best_rtt = 0;
+
+    for (int i = 0; i < TRACK_PROBES; i++) {
+        if (best_rtt > 0 && hi - lo <= best_rtt + 1) break;
+
+        double mid = (lo + hi) / 2;
+        double half_rtt = best_rtt / 2;
+        double server_now = local_ms() + mid;
+        double edge = std::ceil((server_now + half_rtt + 50) / 1000.0) * 1000.0;
+        auto delay = std::chrono::duration<double, std::milli>(std::max(0.0, edge - mid - half_rtt - local_ms()));
+        {
+            // Interruptible, stop_discipline() must not wait out a whole search
+            std::unique_lock<std::mutex> guard(lock);
+            if (wake.wait_for(guard, delay, [this]() { return stopping; })) return false;
+        }
+
+        Sample p;
+        if (!probe(conn, p)) continue;
+        if (best_rtt == 0 || p.rtt_ms < best_rtt) best_rtt = p.rtt_ms;
+        if (!low_rtt(p.rtt_ms, best_rtt)) continue;
+
+        if (p.lo >= hi || p.hi <= lo) {
+            // The prediction was off by more than the slack, continue from this sample alone
+            lo = p.lo;
+            hi = p.hi;
+        } else {
+            lo = std::max(lo, p.lo);
+            hi = std::min(hi, p.hi);
+        }
+    }
+
+    // Only a converged search says more than the model already knows
+    if (best_rtt == 0 || hi - lo > 2 * slack) return false;
+    add_fix(local_ms(), (lo + hi) / 2, (hi - lo) / 2);
+    return true;
+}
+
+void SystemClock::start_discipline(std::unique_ptr<HttpTransport> transport, const std::string& host,
+                                   std::chrono::system_clock::time_point until, int interval_ms, int port) {
+    if (worker.joinable() || !transport) return;
+    lane = std::move(transport);
+    stopping = false;
+
+    worker = std::thread([this, host, port, until, interval_ms]() {
+        auto conn = lane->connect(host, port);
+        if (!conn) return;
+        std::unique_lock<std::mutex> guard(lock);
+        while (!wake.wait_for(guard, std::chrono::milliseconds(interval_ms), [this]() { return stopping; })) {
+            if (ms_until(until) <= 0) break;
+
+            guard.unlock();
+            if (track(*conn)) {
+                std::cout << "[Clock] Tracking: offset " << std::fixed << std::setprecision(1)
+                          << offset_at(local_ms()) << "ms, drift " << std::setprecision(2)
+                          << get_drift_ppm() << "ppm" << std::defaultfloat << std::endl;
+            }
+            guard.lock();
         }
-        WinHttpCloseHandle(hRequest);
-        Sleep(500); // Wait a bit between probes
+        guard.unlock();
+        conn.reset();
+    });
+}
+
+void SystemClock::stop_discipline() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
     }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+    lane.reset();
+}
 
-    this->offset_ms = total_offset / samples;
-    std::cout << "[Clock] Final Average Offset: " << this->offset_ms << "ms (Positive means Local is SLOWER)" << std::endl;
+void SystemClock::fill_report(RunReport& report) const {
+    auto& clock = report.section("clock");
+    clock["offset_ms"] = offset_ms;
+    clock["drift_ppm"] = get_drift_ppm();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto& rows = clock["fixes"] = nlohmann::json::array();
+        for (const Fix& f : fixes) rows.push_back({{"t_ms", f.t_ms}, {"offset_ms", f.offset_ms}, {"error_ms", f.error_ms}});
+    }
+    clock["lead_ms"] = lead_ms;
+    waker.fill_report(report);
+    if (!bounded) return;
+    clock["error_ms"] = get_error_ms();
+    clock["bound_ms"] = {bound_lo, bound_hi};
+    clock["best_rtt_ms"] = best_rtt_ms;
+    clock["agreeing"] = agreeing;
+
+    static const char* USE_NAMES[] = {"used", "high_rtt", "outlier"};
+    auto& rows = clock["samples"] = nlohmann::json::array();
+    for (const Sample& s : history) {
+        rows.push_back({
+            {"kind", s.edge ? "edge" : "coarse"},
+            {"date", s.date},
+            {"rtt_ms", s.rtt_ms},
+            {"low_ms", s.lo},
+            {"high_ms", s.hi},
+            {"use", USE_NAMES[(int)s.use]}
+        });
+    }
 }
 
-void SystemClock::wait_until(int year, int month, int day, int hour, int minute, int second) {
-    std::tm target_tm = {};
-    target_tm.tm_year = year - 1900;
-    target_tm.tm_mon  = month - 1;
-    target_tm.tm_mday = day;
-    target_tm.tm_hour = hour;
-    target_tm.tm_min  = minute;
-    target_tm.tm_sec  = second;
+long long SystemClock::ms_until(std::chrono::system_clock::time_point target_tp) const {
+    // Calculate "Server Time" based on our local clock + offset, the drift model moves the offset along
+    double now_local = local_ms();
+    double now_server_estimated = now_local + offset_at(now_local);
 
-    auto target_tp = std::chrono::system_clock::from_time_t(std::mktime(&target_tm));
-    
-    // Adjust target by offset AND ping buffer
-    // If offset is +1000ms (Server is ahead), we must fire when local clock is 13:59:59 to match server 14:00:00
-    // So we subtract the offset from the wait duration (or effectively shift the target local time)
-    
-    std::cout << "[Clock] Waiting for target time..." << std::endl;
+    return (long long)std::floor(epoch_ms(target_tp) - now_server_estimated);
+}
+
+void SystemClock::sleep_until(std::chrono::system_clock::time_point target_tp) const {
+    double target_ms = epoch_ms(target_tp);
+    double remaining;
+    // Wakes at least once a second so a new drift model moves the deadline
+    while ((remaining = deadline_for(target_ms) - local_ms()) > 0) {
+        WakeEngine::sleep_until(local_ms() + std::min(remaining, 1000.0));
+    }
+}
+
+void SystemClock::wait_until(std::chrono::system_clock::time_point target_tp) {
+    double target_ms = epoch_ms(target_tp);
 
+    // The target is a server time. It becomes a deadline on the monotonic local timeline through
+    // the offset model, so stepping the wall clock (NTP, manual changes) cannot move it. No console
+    // output anywhere in here, this runs on the fire thread inside the quiet window
     while (true) {
-        auto now_local = std::chrono::system_clock::now();
-        
-        // Calculate "Server Time" based on our local clock + offset
-        auto now_server_estimated = now_local + std::chrono::milliseconds(offset_ms);
-        
-        // How many ms until the server hits the target?
-        auto ms_remaining = std::chrono::duration_cast<std::chrono::milliseconds>(target_tp - now_server_estimated).count();
-
-        // Fire slightly early (PING_BUFFER_MS) to hit the server exactly on time
-        if (ms_remaining <= PING_BUFFER_MS) {
-            return; 
+        // Re-derived every round: only the sync subsystem moves the mapping, by publishing a new model.
+        // Fire lead_ms early so the request reaches the server on time
+        double deadline = deadline_for(target_ms) - lead_ms;
+        double remaining = deadline - local_ms();
+        if (remaining <= 0) {
+            return;
         }
 
-        // Hybrid Sleep/Spin
-        if (ms_remaining > 2000) {
-            std::this_thread::sleep_for(std::chrono::seconds(1));
-        } else if (ms_remaining > 50) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        // Absolute sleep up to 50ms before the deadline, waking at least once a second for model updates
+        if (remaining > 50) {
+            WakeEngine::sleep_until(std::min(deadline - 50, local_ms() + 1000));
+            continue;
         }
-        // < 50ms: Busy spin (consume CPU for max precision)
+
+        // Final approach: calibrated sleep, then a pause spin onto the deadline. No logging
+        // here, the caller fires right after; the error is kept in the wake engine
+        waker.wait_until(deadline);
+        return;
     }
 }
\ No newline at end of file
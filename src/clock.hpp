@@ -1,28 +1,156 @@
 #pragma once
-#include <windows.h>
-#include <winhttp.h>
 #include <string>
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "transport.hpp"
+#include "wake.hpp"
+
+class RunReport;
 
 class SystemClock {
 private:
-    long long offset_ms = 0; // The difference: Server Time - Local Time
-    const int PING_BUFFER_MS = 0; // Fire slightly early to account for packet travel
-                                  // (high value might send the request before registration time, change at own discretion)
+    long long offset_ms = 0; // The difference: Server Time - Local Time, as of the last sync
+    double lead_ms = 0; // wait_until() returns this much early to make up for the request's travel time
+                        // (too high a value sends the request before registration opens, see fire.lead)
+    WakeEngine waker; // Final approach of wait_until()
+
+    // One Date probe. The server stamped second S somewhere between our send (t1) and receive
+    // (t2), so the sample bounds the offset: S - t2 <= offset < S + 1s - t1
+    struct Sample {
+        enum class Use { Used, HighRtt, Outlier };
+
+        double t1 = 0, t2 = 0; // Local timeline, see local_ms()
+        std::time_t server_s = 0;
+        std::string date;
+        bool edge = false;  // Timed across a second boundary
+        double rtt_ms = 0;
+        double lo = 0, hi = 0;
+        Use use = Use::Used;
+    };
+    std::vector<Sample> history; // Probes of the last sync, failed ones are not kept
+
+    // Current estimate: the interval the offset lies in, from the samples that passed the filter
+    double bound_lo = 0;
+    double bound_hi = 0;
+    bool bounded = false;
+    double best_rtt_ms = 0;
+    int agreeing = 0;
+    int edge_probes = 8;
+    int probe_count = 5;         // Coarse probes before the edge search, the filter picks among them
+    int probe_interval_ms = 500; // Pause between coarse probes (between rounds on the probe lane)
+
+    // Probe lane: a transport of its own with one connection per parallel probe, so sync probes
+    // never share a socket with the login or fire path
+    std::unique_ptr<HttpTransport> probe_lane;
+    std::vector<std::unique_ptr<HttpConnection>> probe_conns;
 
-    // Helper to parse HTTP Date header (RFC 1123)
-    std::time_t parse_http_date(const std::wstring& date_str);
+    // Offset measurements over time (local ms, offset ms, error ms), the drift model is fitted on them
+    struct Fix {
+        double t_ms;
+        double offset_ms;
+        double error_ms;
+    };
+    std::vector<Fix> fixes;
+    mutable std::mutex lock; // Guards fixes and the discipline thread state
+
+    // Published model: offset(t) = model_offset + model_drift * (t - model_t0). Written under a
+    // sequence counter, so the waiting thread reads it without taking the lock
+    std::atomic<unsigned> model_seq{0};
+    std::atomic<long long> model_t0_us{0};
+    std::atomic<long long> model_offset_us{0};
+    std::atomic<long long> model_drift_ppb{0};
+
+    // Background discipline: its own transport, the main thread's connections are not shared
+    std::unique_ptr<HttpTransport> lane;
+    std::thread worker;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    bool probe(HttpConnection& conn, Sample& out);
+    // Reads the Date of an answered probe and fills in its offset bound
+    bool finish_probe(HttpRequest& request, Sample& out);
+    // One probe per entry of send_at (local ms). With single they run one after another on that
+    // connection, otherwise each on its own probe lane connection, all in flight together
+    void probe_at(HttpConnection* single, const std::vector<double>& send_at, std::vector<Sample>& out);
+    void run_sync(HttpConnection* single);
+    // Adds a measurement, refits offset and drift and publishes the result
+    void add_fix(double t_ms, double offset_ms, double error_ms);
+    // Short edge search around the model's prediction, returns false if it did not converge
+    bool track(HttpConnection& conn);
+    void read_model(double& t0, double& base, double& drift) const;
+    double offset_at(double local) const;
+    // Local time at which the server clock reads server_ms
+    double deadline_for(double server_ms) const;
+    // Re-runs the filter over history: low-RTT selection, then the largest consistent subset
+    void estimate();
+    // Up to rounds searches for the instant the server's Date ticks over, aimed inside
+    // [seed_lo, seed_hi] when that agrees with the samples
+    void refine_with_edges(HttpConnection* single, int rounds, double seed_lo, double seed_hi);
+    void print_samples() const;
 
 public:
     SystemClock();
-    
+    ~SystemClock();
+
+    // Local timeline every measurement and deadline uses, in ms: CLOCK_MONOTONIC_RAW on Linux,
+    // steady_clock elsewhere, anchored to the wall clock once at startup
+    static double local_ms();
+
     // Connects to ITU server, reads the Date header, and calculates drift
-    void sync_with_server(HINTERNET hConnect);
+    void sync_with_server(HttpConnection& conn);
+    // Same on the probe lane, its probes run in parallel bursts
+    void sync_with_server();
+
+    // Sets up the probe lane: burst connections to host on a transport of its own
+    void set_probe_lane(std::unique_ptr<HttpTransport> transport, const std::string& host, int burst, int port = 443);
+    bool has_probe_lane() const { return !probe_conns.empty(); }
+    // Coarse probes per sync and the pause between them
+    void set_probe_plan(int count, int interval_ms) { probe_count = std::max(count, 1); probe_interval_ms = std::max(interval_ms, 0); }
+
+    // High-precision wait loop (Sleeps then Spins) until the server clock reaches target_tp (UTC).
+    // Does no I/O, the caller announces the wait
+    void wait_until(std::chrono::system_clock::time_point target_tp);
+
+    // Lead of wait_until() in ms, set before the final wait
+    void set_lead_ms(double ms) { lead_ms = ms; }
+    double get_lead_ms() const { return lead_ms; }
+
+    // Plain sleep until the server clock reaches target_tp, for the phases before the fire
+    void sleep_until(std::chrono::system_clock::time_point target_tp) const;
 
-    // High-precision wait loop (Sleeps then Spins)
-    // Takes the target time from config (e.g., 14:00:00)
-    void wait_until(int year, int month, int day, int hour, int minute, int second = 0);
+    // Milliseconds until the server clock reaches the target (negative once it has passed)
+    long long ms_until(std::chrono::system_clock::time_point target_tp) const;
+
+    // Number of rounds aimed at the server's second edge after the coarse pass, 0 disables them.
+    // A round is one probe, or one probe per connection on the probe lane
+    void set_edge_probes(int n) { edge_probes = n; }
+
+    // Sleep/spin engine used for the last milliseconds before the target, calibrate at startup
+    WakeEngine& wake_engine() { return waker; }
+
+    // Keeps measuring the offset every interval_ms on a connection of transport until the server
+    // clock reaches until, refining the drift model that wait_until() and ms_until() follow
+    void start_discipline(std::unique_ptr<HttpTransport> transport, const std::string& host,
+                          std::chrono::system_clock::time_point until, int interval_ms, int port = 443);
+    void stop_discipline();
 
     // specific getter for debug purposes
-    long long get_offset() const { return offset_ms; }
+    long long get_offset() const;
+    // Fitted drift of the local clock against the server, in ppm (positive: local runs slow)
+    double get_drift_ppm() const { return (double)model_drift_ppb.load(std::memory_order_relaxed) / 1000.0; }
+    // Server clock in epoch ms at a point on the local timeline
+    double server_ms_at(double local) const { return local + offset_at(local); }
+    // Lowest probe RTT of the last sync, -1 before the first one
+    double get_best_rtt_ms() const { return bounded ? best_rtt_ms : -1; }
+    // Half width of the confidence interval around the offset, -1 before the first sync
+    double get_error_ms() const { return bounded ? (bound_hi - bound_lo) / 2 : -1; }
+
+    void fill_report(RunReport& report) const;
 };
\ No newline at end of file
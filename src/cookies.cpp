@@ -0,0 +1,148 @@
+#include "cookies.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// --- INTERNAL HELPERS ---
+
+static std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t");
+    if (b == std::string::npos) return "";
+    size_t e = s.find_last_not_of(" \t");
+    return s.substr(b, e - b + 1);
+}
+
+static std::string lower(std::string s) {
+    for (char& c : s) c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+// "Wed, 09 Jun 2021 10:18:14 GMT" or the old "Wed, 09-Jun-2021 10:18:14 GMT" form
+static std::time_t parse_cookie_date(const std::string& value) {
+    static const char* months = "janfebmaraprmayjunjulaugsepoctnovdec";
+    int day = 0, year = 0, h = 0, m = 0, s = 0;
+    char mon[4] = {};
+    size_t comma = value.find(',');
+    const char* p = value.c_str() + (comma == std::string::npos ? 0 : comma + 1);
+    if (std::sscanf(p, " %d%*[ -]%3s%*[ -]%d %d:%d:%d", &day, mon, &year, &h, &m, &s) != 6) return 0;
+
+    const char* found = std::strstr(months, lower(mon).c_str());
+    if (!found || (found - months) % 3 != 0) return 0;
+    if (year < 100) year += (year < 70) ? 2000 : 1900;
+
+    std::tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon  = (int)(found - months) / 3;
+    tm.tm_mday = day;
+    tm.tm_hour = h;
+    tm.tm_min  = m;
+    tm.tm_sec  = s;
+#ifdef _WIN32
+    return _mkgmtime(&tm);
+#else
+    return timegm(&tm);
+#endif
+}
+
+static bool domain_matches(const std::string& host, const Cookie& c) {
+    if (c.host_only) return host == c.domain;
+    if (host == c.domain) return true;
+    return host.size() > c.domain.size() &&
+           host.compare(host.size() - c.domain.size(), c.domain.size(), c.domain) == 0 &&
+           host[host.size() - c.domain.size() - 1] == '.';
+}
+
+static bool path_matches(const std::string& path, const std::string& cookie_path) {
+    if (path.compare(0, cookie_path.size(), cookie_path) != 0) return false;
+    return path.size() == cookie_path.size() || cookie_path.back() == '/' || path[cookie_path.size()] == '/';
+}
+
+// --- CLASS METHODS ---
+
+void CookieJar::store(const std::string& host, const std::string& request_path, const std::string& set_cookie) {
+    size_t semi = set_cookie.find(';');
+    std::string pair = set_cookie.substr(0, semi);
+    size_t eq = pair.find('=');
+    if (eq == std::string::npos) return;
+
+    Cookie c;
+    c.name = trim(pair.substr(0, eq));
+    c.value = trim(pair.substr(eq + 1));
+    c.domain = lower(host);
+    if (c.name.empty()) return;
+
+    // Default path is the directory of the request URI
+    size_t q = request_path.find('?');
+    std::string dir = request_path.substr(0, q);
+    size_t slash = dir.rfind('/');
+    c.path = (slash == std::string::npos || slash == 0) ? "/" : dir.substr(0, slash);
+
+    bool expired = false;
+    bool has_max_age = false;
+    while (semi != std::string::npos) {
+        size_t next = set_cookie.find(';', semi + 1);
+        std::string attr = set_cookie.substr(semi + 1, next == std::string::npos ? std::string::npos : next - semi - 1);
+        semi = next;
+
+        size_t aeq = attr.find('=');
+        std::string key = lower(trim(attr.substr(0, aeq)));
+        std::string val = (aeq == std::string::npos) ? "" : trim(attr.substr(aeq + 1));
+
+        if (key == "domain" && !val.empty()) {
+            if (val[0] == '.') val.erase(0, 1);
+            val = lower(val);
+            // Reject cookies for domains the host does not belong to
+            Cookie probe;
+            probe.domain = val;
+            probe.host_only = false;
+            if (!domain_matches(c.domain, probe)) return;
+            c.domain = val;
+            c.host_only = false;
+        } else if (key == "path" && !val.empty() && val[0] == '/') {
+            c.path = val;
+        } else if (key == "secure") {
+            c.secure = true;
+        } else if (key == "max-age") {
+            has_max_age = true;
+            long long age = std::atoll(val.c_str());
+            expired = age <= 0;
+            if (!expired) c.expires = std::time(nullptr) + (std::time_t)age;
+        } else if (key == "expires" && !has_max_age) {
+            std::time_t t = parse_cookie_date(val);
+            if (t != 0 && t <= std::time(nullptr)) expired = true;
+            else c.expires = t;
+        }
+    }
+
+    // Replace an existing cookie with the same identity
+    cookies.erase(std::remove_if(cookies.begin(), cookies.end(), [&c](const Cookie& o) {
+        return o.name == c.name && o.domain == c.domain && o.path == c.path;
+    }), cookies.end());
+
+    if (!expired) cookies.push_back(c);
+}
+
+std::string CookieJar::header_for(const std::string& host, const std::string& path) const {
+    std::string h = lower(host);
+    std::string p = path.substr(0, path.find('?'));
+    std::time_t now = std::time(nullptr);
+
+    std::string out;
+    for (const auto& c : cookies) {
+        if (c.expires != 0 && c.expires <= now) continue;
+        if (!domain_matches(h, c) || !path_matches(p, c.path)) continue;
+        if (!out.empty()) out += "; ";
+        out += c.name + "=" + c.value;
+    }
+    return out;
+}
+
+void CookieJar::restore(const std::vector<Cookie>& saved) {
+    std::time_t now = std::time(nullptr);
+    cookies.clear();
+    for (const Cookie& c : saved) {
+        if (c.expires == 0 || c.expires > now) cookies.push_back(c);
+    }
+}
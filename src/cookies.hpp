@@ -0,0 +1,33 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <ctime>
+
+// Minimal RFC 6265 cookie store for backends without built-in cookie handling
+struct Cookie {
+    std::string name;
+    std::string value;
+    std::string domain;
+    std::string path = "/";
+    bool host_only = true;
+    bool secure = false;
+    std::time_t expires = 0; // 0 means session cookie
+};
+
+class CookieJar {
+private:
+    std::vector<Cookie> cookies;
+
+public:
+    // Stores a single Set-Cookie header received from host
+    void store(const std::string& host, const std::string& request_path, const std::string& set_cookie);
+
+    // Builds the Cookie header value for a request, empty if nothing matches
+    std::string header_for(const std::string& host, const std::string& path) const;
+
+    // Every stored cookie, session cookies included, for saving the session
+    const std::vector<Cookie>& all() const { return cookies; }
+    // Replaces the contents with saved cookies, expired ones are dropped
+    void restore(const std::vector<Cookie>& saved);
+    void clear() { cookies.clear(); }
+};
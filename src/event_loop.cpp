@@ -0,0 +1,307 @@
+#ifdef __linux__
+#include "event_loop.hpp"
+#include <linux/io_uring.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+// --- INTERNAL HELPERS ---
+
+static uint64_t make_tag(int fd, uint32_t gen) {
+    return ((uint64_t)gen << 32) | (uint32_t)fd;
+}
+
+// Kernel completions that do not belong to a watch (timers, removals) carry this bit
+const uint64_t INTERNAL_TAG = 1ull << 63;
+
+class EpollLoop : public EventLoop {
+private:
+    int epfd;
+
+public:
+    EpollLoop() : epfd(epoll_create1(EPOLL_CLOEXEC)) {}
+    ~EpollLoop() override {
+        if (epfd >= 0) close(epfd);
+    }
+
+    bool ok() const { return epfd >= 0; }
+    const char* name() const override { return "epoll"; }
+
+protected:
+    bool arm(int fd, uint32_t events, uint64_t tag) override {
+        epoll_event ev = {};
+        ev.events = events | EPOLLONESHOT;
+        ev.data.u64 = tag;
+        if (epoll_ctl(epfd, EPOLL_CTL_MOD, fd, &ev) == 0) return true;
+        return errno == ENOENT && epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) == 0;
+    }
+
+    void disarm(int fd, uint64_t) override {
+        epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+
+    int collect(int timeout_ms, Ready* out) override {
+        epoll_event evs[MAX_READY];
+        int n = epoll_wait(epfd, evs, MAX_READY, timeout_ms);
+        for (int i = 0; i < n; i++) out[i] = {evs[i].data.u64, evs[i].events};
+        return n < 0 ? 0 : n;
+    }
+};
+
+// io_uring through the raw syscalls (no liburing dependency). Polls are submitted as
+// IORING_OP_POLL_ADD, timeouts as IORING_OP_TIMEOUT so one io_uring_enter both submits
+// the pending polls and waits.
+class UringLoop : public EventLoop {
+private:
+    static const unsigned ENTRIES = 64;
+
+    int ring = -1;
+    void* sq_map = MAP_FAILED;
+    void* cq_map = MAP_FAILED;
+    size_t sq_size = 0, cq_size = 0, sqe_size = 0;
+    io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+
+    unsigned *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    io_uring_cqe* cqes;
+    unsigned to_submit = 0;
+
+    __kernel_timespec timer = {};
+    uint64_t timer_seq = 0;
+    bool timer_pending = false;
+
+    int enter(unsigned submit, unsigned wait_nr) {
+        unsigned flags = wait_nr ? IORING_ENTER_GETEVENTS : 0;
+        int ret;
+        do {
+            ret = (int)syscall(__NR_io_uring_enter, ring, submit, wait_nr, flags, nullptr, 0);
+        } while (ret < 0 && errno == EINTR);
+        return ret;
+    }
+
+    io_uring_sqe* next_sqe() {
+        unsigned tail = *sq_tail;
+        if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= ENTRIES) {
+            // Ring full, hand what we have to the kernel first
+            if (enter(to_submit, 0) >= 0) to_submit = 0;
+            if (tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= ENTRIES) return nullptr;
+        }
+        unsigned idx = tail & *sq_mask;
+        io_uring_sqe* sqe = &sqes[idx];
+        std::memset(sqe, 0, sizeof(*sqe));
+        sq_array[idx] = idx;
+        return sqe;
+    }
+
+    void push() {
+        __atomic_store_n(sq_tail, *sq_tail + 1, __ATOMIC_RELEASE);
+        to_submit++;
+    }
+
+public:
+    UringLoop() {
+        io_uring_params p = {};
+        ring = (int)syscall(__NR_io_uring_setup, ENTRIES, &p);
+        if (ring < 0) return;
+
+        sq_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        if (p.features & IORING_FEAT_SINGLE_MMAP) sq_size = cq_size = (sq_size > cq_size ? sq_size : cq_size);
+
+        sq_map = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+        if (sq_map == MAP_FAILED) return;
+        cq_map = (p.features & IORING_FEAT_SINGLE_MMAP) ? sq_map
+                 : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+        if (cq_map == MAP_FAILED) return;
+        sqe_size = p.sq_entries * sizeof(io_uring_sqe);
+        sqes = (io_uring_sqe*)mmap(nullptr, sqe_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) return;
+
+        char* sq = (char*)sq_map;
+        sq_head = (unsigned*)(sq + p.sq_off.head);
+        sq_tail = (unsigned*)(sq + p.sq_off.tail);
+        sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+        sq_array = (unsigned*)(sq + p.sq_off.array);
+
+        char* cq = (char*)cq_map;
+        cq_head = (unsigned*)(cq + p.cq_off.head);
+        cq_tail = (unsigned*)(cq + p.cq_off.tail);
+        cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+        cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+    }
+
+    ~UringLoop() override {
+        if (sqes != MAP_FAILED) munmap(sqes, sqe_size);
+        if (cq_map != MAP_FAILED && cq_map != sq_map) munmap(cq_map, cq_size);
+        if (sq_map != MAP_FAILED) munmap(sq_map, sq_size);
+        if (ring >= 0) close(ring);
+    }
+
+    // Setup can succeed and still be useless (seccomp filters, old kernels without POLL_ADD),
+    // so a no-op round trip decides whether we keep io_uring
+    bool ok() {
+        if (ring < 0 || sqes == MAP_FAILED) return false;
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_NOP;
+        sqe->user_data = INTERNAL_TAG;
+        push();
+        if (enter(to_submit, 1) < 0) return false;
+        to_submit = 0;
+        Ready out[MAX_READY];
+        collect(0, out);
+        return true;
+    }
+
+    const char* name() const override { return "io_uring"; }
+
+protected:
+    bool arm(int fd, uint32_t events, uint64_t tag) override {
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return false;
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->fd = fd;
+        sqe->poll32_events = events;
+        sqe->user_data = tag;
+        push();
+        return true;
+    }
+
+    void disarm(int, uint64_t tag) override {
+        io_uring_sqe* sqe = next_sqe();
+        if (!sqe) return;
+        sqe->opcode = IORING_OP_POLL_REMOVE;
+        sqe->addr = tag;
+        sqe->user_data = INTERNAL_TAG;
+        push();
+    }
+
+    int collect(int timeout_ms, Ready* out) override {
+        // An unexpired timer from the previous call would wake us early, cancel it first
+        if (timer_pending) {
+            if (io_uring_sqe* sqe = next_sqe()) {
+                sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+                sqe->addr = INTERNAL_TAG | timer_seq;
+                sqe->user_data = INTERNAL_TAG;
+                push();
+            }
+            timer_pending = false;
+        }
+
+        unsigned wait_nr = 0;
+        if (timeout_ms != 0 && __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) == *cq_head) {
+            if (timeout_ms > 0) {
+                io_uring_sqe* sqe = next_sqe();
+                if (sqe) {
+                    timer.tv_sec = timeout_ms / 1000;
+                    timer.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+                    sqe->opcode = IORING_OP_TIMEOUT;
+                    sqe->addr = (uint64_t)(uintptr_t)&timer;
+                    sqe->len = 1;
+                    sqe->user_data = INTERNAL_TAG | ++timer_seq;
+                    push();
+                    timer_pending = true;
+                }
+            }
+            wait_nr = 1;
+        }
+        if (enter(to_submit, wait_nr) >= 0) to_submit = 0;
+
+        int n = 0;
+        unsigned head = *cq_head;
+        unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail && n < MAX_READY) {
+            const io_uring_cqe& cqe = cqes[head & *cq_mask];
+            if (cqe.user_data == (INTERNAL_TAG | timer_seq)) {
+                timer_pending = false;
+            } else if (!(cqe.user_data & INTERNAL_TAG)) {
+                // res is the revents mask, or -errno (e.g. -ECANCELED after a removal)
+                out[n++] = {cqe.user_data, cqe.res < 0 ? (uint32_t)EPOLLERR : (uint32_t)cqe.res};
+            }
+            head++;
+        }
+        __atomic_store_n(cq_head, head, __ATOMIC_RELEASE);
+        return n;
+    }
+};
+
+// --- CLASS METHODS ---
+
+std::unique_ptr<EventLoop> EventLoop::create(const std::string& backend) {
+    if (backend == "auto" || backend == "io_uring") {
+        auto uring = std::make_unique<UringLoop>();
+        if (uring->ok()) return uring;
+        if (backend == "io_uring") return nullptr;
+    }
+    if (backend == "auto" || backend == "epoll") {
+        auto epoll = std::make_unique<EpollLoop>();
+        if (epoll->ok()) return epoll;
+    }
+    return nullptr;
+}
+
+bool EventLoop::watch(int fd, uint32_t events, Handler handler) {
+    if (fd < 0) return false;
+    if ((size_t)fd >= watches.size()) watches.resize((size_t)fd + 16);
+
+    Watch& w = watches[fd];
+    if (w.gen != 0) disarm(fd, make_tag(fd, w.gen));
+    if (++next_gen == 0) next_gen = 1;
+    w.gen = next_gen;
+    w.handler = std::move(handler);
+    if (arm(fd, events, make_tag(fd, w.gen))) return true;
+
+    w.gen = 0;
+    w.handler = nullptr;
+    return false;
+}
+
+void EventLoop::unwatch(int fd) {
+    if (fd < 0 || (size_t)fd >= watches.size() || watches[fd].gen == 0) return;
+    disarm(fd, make_tag(fd, watches[fd].gen));
+    watches[fd].gen = 0;
+    watches[fd].handler = nullptr;
+}
+
+int EventLoop::run_once(int timeout_ms) {
+    // Local array: a handler may block on its own socket and re-enter the loop
+    Ready ready[MAX_READY];
+    int n = collect(timeout_ms, ready);
+
+    int ran = 0;
+    for (int i = 0; i < n; i++) {
+        int fd = (int)(uint32_t)ready[i].tag;
+        uint32_t gen = (uint32_t)(ready[i].tag >> 32);
+        if ((size_t)fd >= watches.size() || watches[fd].gen != gen) continue; // Stale, replaced or removed
+
+        // One-shot: clear before calling so the handler can re-arm
+        Handler handler = std::move(watches[fd].handler);
+        watches[fd].gen = 0;
+        watches[fd].handler = nullptr;
+        handler(ready[i].events);
+        ran++;
+    }
+    return ran;
+}
+
+bool EventLoop::wait(int fd, uint32_t events, int timeout_ms) {
+    bool ready = false;
+    if (!watch(fd, events, [&ready](uint32_t) { ready = true; })) return false;
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!ready) {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+        if (left <= 0) {
+            unwatch(fd);
+            return false;
+        }
+        run_once((int)left);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,59 @@
+#pragma once
+#ifdef __linux__
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Readiness loop shared by every socket of the Linux transport. Watches are one-shot: a
+// handler runs once when its fd becomes ready and has to re-arm itself for more. Blocking
+// waits go through the same loop, so other exchanges keep progressing while one request
+// waits on its socket. io_uring (IORING_OP_POLL_ADD) when the kernel allows it, epoll otherwise.
+class EventLoop {
+public:
+    // Gets the ready events (EPOLLIN, EPOLLOUT, EPOLLERR ...)
+    using Handler = std::function<void(uint32_t events)>;
+
+    virtual ~EventLoop() = default;
+
+    // "auto" tries io_uring first and falls back to epoll, "io_uring" / "epoll" force one.
+    // Returns nullptr if the requested backend cannot be set up
+    static std::unique_ptr<EventLoop> create(const std::string& backend = "auto");
+
+    // Runs handler once fd is ready for events. Replaces an earlier watch on the same fd
+    bool watch(int fd, uint32_t events, Handler handler);
+    // Drops the watch on fd, must be called before the fd is closed
+    void unwatch(int fd);
+
+    // Waits up to timeout_ms and runs the handlers of ready fds. Returns how many ran
+    int run_once(int timeout_ms);
+
+    // Blocks until fd is ready for events, running other handlers meanwhile. False on timeout
+    bool wait(int fd, uint32_t events, int timeout_ms);
+
+    virtual const char* name() const = 0;
+
+protected:
+    // tag identifies one watch: fd in the low half, generation in the high half
+    struct Ready {
+        uint64_t tag;
+        uint32_t events;
+    };
+    static const int MAX_READY = 64;
+
+    virtual bool arm(int fd, uint32_t events, uint64_t tag) = 0;
+    virtual void disarm(int fd, uint64_t tag) = 0;
+    // Fills out with up to MAX_READY completions, waits at most timeout_ms for the first one
+    virtual int collect(int timeout_ms, Ready* out) = 0;
+
+private:
+    struct Watch {
+        uint32_t gen = 0; // 0 means not watched
+        Handler handler;
+    };
+    std::vector<Watch> watches; // Indexed by fd, grows once and is reused afterwards
+    uint32_t next_gen = 1;
+};
+
+#endif
@@ -0,0 +1,107 @@
+#include "fire.hpp"
+#include <algorithm>
+#include <iostream>
+
+FireMode parse_fire_mode(const std::string& name) {
+    return name == "split" ? FireMode::Split : FireMode::Full;
+}
+
+LeadMode parse_lead_mode(const std::string& name) {
+    return name == "adaptive" ? LeadMode::Adaptive : LeadMode::Fixed;
+}
+
+LeadEstimate estimate_lead(double sync_rtt_ms, double warm_rtt_ms, double clock_error_ms, double max_lead_ms) {
+    LeadEstimate lead;
+    if (warm_rtt_ms > 0 && (sync_rtt_ms <= 0 || warm_rtt_ms <= sync_rtt_ms)) {
+        lead.rtt_ms = warm_rtt_ms;
+        lead.source = "warm connection";
+    } else if (sync_rtt_ms > 0) {
+        lead.rtt_ms = sync_rtt_ms;
+        lead.source = "clock sync";
+    } else {
+        lead.source = "no measurement";
+        return lead;
+    }
+
+    lead.one_way_ms = lead.rtt_ms / 2;
+    lead.lead_ms = std::clamp(lead.one_way_ms - std::max(clock_error_ms, 0.0), 0.0, std::max(max_lead_ms, 0.0));
+    return lead;
+}
+
+// --- FIRE PLAN ---
+
+FirePlan::FirePlan(const std::string& headers, const std::string& body, size_t tail_bytes)
+    : buffer(headers.size() + body.size()), header_len(headers.size()), body_len(body.size()), tail_bytes(tail_bytes) {
+    buffer.append(headers.data(), headers.size());
+    buffer.append(body.data(), body.size());
+
+    // Keep at least one byte back, and never more than the whole body
+    if (this->tail_bytes == 0) this->tail_bytes = 1;
+    if (this->tail_bytes > body_len) this->tail_bytes = body_len;
+}
+
+// --- FIRE REQUEST ---
+
+FireRequest::FireRequest(HttpConnection& conn, const FirePlan& plan) : conn(conn), plan(plan) {}
+
+bool FireRequest::prepare() {
+    streamed = false;
+    request = conn.open("POST", "/api/ders-kayit/v21");
+    if (!request) {
+        error = "could not open request";
+        return prepared = false;
+    }
+    if (!request->stage(plan.headers(), plan.body(), plan.body_size())) {
+        error = request->last_error();
+        request.reset();
+        return prepared = false;
+    }
+    return prepared = true;
+}
+
+bool FireRequest::refresh() {
+    if (!prepared || streamed || !request->is_stale()) return prepared;
+    std::cout << "[Fire] Connection changed since the request was prepared, rendering it again." << std::endl;
+    return prepare();
+}
+
+bool FireRequest::stream_head() {
+    if (streamed) return true;
+    if (!prepared && !prepare()) return false;
+
+    if (!request->transmit(plan.split_point())) {
+        error = request->last_error();
+        std::cout << "[Fire] Staging failed (" << error << "), falling back to a full send." << std::endl;
+        prepared = false;
+        return false;
+    }
+
+    streamed = true;
+    std::cout << "[Fire] Staged " << plan.split_point() << "/" << plan.body_size() << " body bytes, holding back "
+              << plan.body_size() - plan.split_point() << "." << std::endl;
+    return true;
+}
+
+bool FireRequest::fire() {
+    if (!prepared && !prepare()) return false;
+    if (request->transmit(plan.body_size())) return true;
+
+    error = request->last_error();
+    if (!streamed) {
+        // The socket dropped inside the critical window. Rendering again allocates, but it beats
+        // not registering at all
+        if (!request->is_stale()) return false;
+        std::cout << "[Fire] " << error << " Rendering again on the fire path." << std::endl;
+        if (!prepare()) return false;
+        if (request->transmit(plan.body_size())) return true;
+        error = request->last_error();
+        return false;
+    }
+
+    // The server never saw a complete request, so sending it again from scratch is safe
+    std::cout << "[Fire] Releasing staged bytes failed (" << error << "), resending in full." << std::endl;
+    if (!prepare()) return false;
+    if (request->transmit(plan.body_size())) return true;
+    error = request->last_error();
+    return false;
+}
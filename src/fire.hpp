@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include "transport.hpp"
+#include "memory.hpp"
+
+// How the registration request is put on the wire
+enum class FireMode {
+    Full,  // Whole request is written at T0
+    Split  // Request line, headers and most of the body go out early, the tail is released at T0
+};
+
+FireMode parse_fire_mode(const std::string& name);
+
+// How far ahead of the target the request is written
+enum class LeadMode {
+    Fixed,   // fire.lead_ms, 0 by default
+    Adaptive // Estimated one-way latency to the server
+};
+
+LeadMode parse_lead_mode(const std::string& name);
+
+struct LeadEstimate {
+    double rtt_ms = -1;    // Round trip the estimate is based on, -1 if none was measured
+    const char* source = "fixed";
+    double one_way_ms = 0; // Expected time from our write to the server reading the request
+    double lead_ms = 0;    // What the wait actually subtracts
+};
+
+// Adaptive lead: half of the lowest round trip seen on the sync probes or the warm fire
+// connection (write to first response byte), less the clock's error so the request cannot
+// land before T0 at the early edge of the offset interval, clamped to [0, max_lead_ms].
+// Negative inputs mean "not measured"
+LeadEstimate estimate_lead(double sync_rtt_ms, double warm_rtt_ms, double clock_error_ms, double max_lead_ms);
+
+// Exact registration request bytes, built once after token acquisition. Header block and body
+// sit back to back in one pre-faulted, memory-locked buffer that nothing rewrites afterwards.
+class FirePlan {
+private:
+    LockedBuffer buffer;
+    size_t header_len;
+    size_t body_len;
+    size_t tail_bytes;
+
+public:
+    FirePlan(const std::string& headers, const std::string& body, size_t tail_bytes);
+
+    std::string_view headers() const { return std::string_view(buffer.data(), header_len); }
+    const char* body() const { return buffer.data() + header_len; }
+    size_t body_size() const { return body_len; }
+
+    // Body offset up to which split mode streams ahead of T0
+    size_t split_point() const { return body_len - tail_bytes; }
+
+    bool is_locked() const { return buffer.is_locked(); }
+};
+
+class FireRequest {
+private:
+    HttpConnection& conn;
+    const FirePlan& plan;
+    std::unique_ptr<HttpRequest> request;
+    std::string error;
+    bool prepared = false;
+    bool streamed = false;
+
+public:
+    FireRequest(HttpConnection& conn, const FirePlan& plan);
+
+    // Opens the request and renders it into the backend's wire form. Everything that
+    // allocates happens here, ahead of the critical window
+    bool prepare();
+
+    // prepare() again if the connection was re-armed onto a new session since the last one.
+    // Called from the wait loop, so the new rendering also happens before the critical window
+    bool refresh();
+
+    // Split mode: streams everything except the held back tail of the body
+    bool stream_head();
+    bool is_streamed() const { return streamed; }
+
+    // Releases the held back bytes, or sends the whole request if nothing was streamed
+    bool fire();
+
+    // The in-flight exchange, valid after fire()
+    HttpRequest& response() { return *request; }
+    const std::string& last_error() const { return error; }
+};
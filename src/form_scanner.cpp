@@ -0,0 +1,100 @@
+#include "form_scanner.hpp"
+#include <cstring>
+
+// --- INTERNAL HELPERS ---
+
+// True if the attribute name right before the '=' at name_end is name
+static bool attribute_is(std::string_view body, size_t name_end, std::string_view name) {
+    if (name_end < name.size() || body.compare(name_end - name.size(), name.size(), name) != 0) return false;
+    if (name_end == name.size()) return true;
+    char before = body[name_end - name.size() - 1];
+    return before == ' ' || before == '\t' || before == '\n' || before == '\r' || before == '<';
+}
+
+static const char* find_byte(const char* from, const char* to, char c) {
+    return from < to ? (const char*)std::memchr(from, c, (size_t)(to - from)) : nullptr;
+}
+
+// --- CLASS METHODS ---
+
+FormScanner::FormScanner(std::initializer_list<std::string_view> ids) {
+    for (std::string_view id : ids) fields.push_back(Field{std::string(id), Range()});
+    missing = fields.size() + 1;
+}
+
+void FormScanner::end_tag() {
+    tag_field = -1;
+    tag_value = Range();
+}
+
+void FormScanner::on_attribute(std::string_view body, size_t name_end, size_t start, size_t len) {
+    if (attribute_is(body, name_end, "value")) {
+        tag_value = Range{start, len, true};
+    } else if (attribute_is(body, name_end, "id")) {
+        std::string_view id = body.substr(start, len);
+        for (size_t i = 0; i < fields.size(); i++) {
+            if (!fields[i].value.found && fields[i].id == id) {
+                tag_field = (int)i;
+                break;
+            }
+        }
+    } else if (!form_action.found && attribute_is(body, name_end, "action")) {
+        form_action = Range{start, len, true};
+        missing--;
+    }
+
+    // First value="" of the tag wins, like a browser reads the attribute
+    if (tag_field >= 0 && tag_value.found) {
+        fields[tag_field].value = tag_value;
+        missing--;
+        end_tag();
+    }
+}
+
+bool FormScanner::scan(std::string_view body) {
+    const char* base = body.data();
+    const char* end = base + body.size();
+
+    while (missing > 0) {
+        const char* quote = find_byte(base + pos, end, '"');
+        if (!quote) {
+            // A '>' in the text scanned so far closes the tag
+            if (tag_field >= 0 || tag_value.found) {
+                if (find_byte(base + pos, end, '>')) end_tag();
+            }
+            // Nothing past here can start a value yet, the next call resumes at the end
+            pos = body.size();
+            break;
+        }
+
+        size_t q = (size_t)(quote - base);
+        if ((tag_field >= 0 || tag_value.found) && find_byte(base + pos, quote, '>')) end_tag();
+
+        // Only a quote right after '=' opens an attribute value, stray quotes in text are skipped
+        if (q == 0 || body[q - 1] != '=') {
+            pos = q + 1;
+            continue;
+        }
+
+        const char* close = find_byte(quote + 1, end, '"');
+        if (!close) {
+            // The value is cut off at the end of what has arrived, look at it again next time
+            pos = q;
+            break;
+        }
+        size_t start = q + 1;
+        on_attribute(body, q - 1, start, (size_t)(close - base) - start);
+        pos = (size_t)(close - base) + 1;
+    }
+    return missing == 0;
+}
+
+std::string_view FormScanner::value(std::string_view body, size_t index) const {
+    if (index >= fields.size() || !fields[index].value.found) return {};
+    return body.substr(fields[index].value.start, fields[index].value.len);
+}
+
+std::string_view FormScanner::action(std::string_view body) const {
+    if (!form_action.found) return {};
+    return body.substr(form_action.start, form_action.len);
+}
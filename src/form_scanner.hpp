@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Single pass scanner for the hidden fields and the action of an ASP.NET login form. It is fed
+// the page while it downloads: every call passes the whole body read so far, and only the part
+// past the previous call is looked at. It hops from one attribute quote to the next with memchr
+// (vectorized in the C library), so it never compares text outside attribute values.
+// Results are offsets into the body, the body may move between calls (a growing buffer).
+class FormScanner {
+private:
+    struct Range {
+        size_t start = 0, len = 0;
+        bool found = false;
+    };
+    struct Field {
+        std::string id;
+        Range value;
+    };
+
+    std::vector<Field> fields;
+    Range form_action;
+    size_t pos = 0;     // Everything before it has been scanned
+    size_t missing = 0; // Fields (and the action) not seen yet
+
+    // Current tag: the field its id="" matched and its value="", whichever came first
+    int tag_field = -1;
+    Range tag_value;
+
+    void end_tag();
+    void on_attribute(std::string_view body, size_t name_end, size_t start, size_t len);
+
+public:
+    explicit FormScanner(std::initializer_list<std::string_view> ids);
+
+    // Scans the new part of body, true once every field and the form action have been seen
+    bool scan(std::string_view body);
+    bool complete() const { return missing == 0; }
+
+    // Value of the index-th id given to the constructor, empty if it was not seen
+    std::string_view value(std::string_view body, size_t index) const;
+    bool has_action() const { return form_action.found; }
+    // Raw action attribute (still HTML-escaped), empty if there was none
+    std::string_view action(std::string_view body) const;
+    // Bytes of the body scanned so far
+    size_t scanned() const { return pos; }
+};
@@ -0,0 +1,369 @@
+#include "hpack.hpp"
+
+// --- TABLES ---
+
+// Generated from RFC 7541 Appendix A and B
+static const uint32_t HUFFMAN_CODES[256] = {
+    0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+    0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+    0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+    0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+    0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+    0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+    0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+    0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+    0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+    0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+    0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+    0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+    0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+    0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+    0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+    0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+    0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+    0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+    0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+    0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+    0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+    0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+    0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+    0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+    0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+    0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+    0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+    0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+    0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+    0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+    0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+    0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+};
+static const uint8_t HUFFMAN_BITS[256] = {
+    13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+    28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+    6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+    5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+    13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+    7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+    15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+    6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+    20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+    24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+    22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+    21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+    26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+    19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+    20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+    26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+};
+static const char* const STATIC_TABLE[61][2] = {
+    {":authority", ""},
+    {":method", "GET"},
+    {":method", "POST"},
+    {":path", "/"},
+    {":path", "/index.html"},
+    {":scheme", "http"},
+    {":scheme", "https"},
+    {":status", "200"},
+    {":status", "204"},
+    {":status", "206"},
+    {":status", "304"},
+    {":status", "400"},
+    {":status", "404"},
+    {":status", "500"},
+    {"accept-charset", ""},
+    {"accept-encoding", "gzip, deflate"},
+    {"accept-language", ""},
+    {"accept-ranges", ""},
+    {"accept", ""},
+    {"access-control-allow-origin", ""},
+    {"age", ""},
+    {"allow", ""},
+    {"authorization", ""},
+    {"cache-control", ""},
+    {"content-disposition", ""},
+    {"content-encoding", ""},
+    {"content-language", ""},
+    {"content-length", ""},
+    {"content-location", ""},
+    {"content-range", ""},
+    {"content-type", ""},
+    {"cookie", ""},
+    {"date", ""},
+    {"etag", ""},
+    {"expect", ""},
+    {"expires", ""},
+    {"from", ""},
+    {"host", ""},
+    {"if-match", ""},
+    {"if-modified-since", ""},
+    {"if-none-match", ""},
+    {"if-range", ""},
+    {"if-unmodified-since", ""},
+    {"last-modified", ""},
+    {"link", ""},
+    {"location", ""},
+    {"max-forwards", ""},
+    {"proxy-authenticate", ""},
+    {"proxy-authorization", ""},
+    {"range", ""},
+    {"referer", ""},
+    {"refresh", ""},
+    {"retry-after", ""},
+    {"server", ""},
+    {"set-cookie", ""},
+    {"strict-transport-security", ""},
+    {"transfer-encoding", ""},
+    {"user-agent", ""},
+    {"vary", ""},
+    {"via", ""},
+    {"www-authenticate", ""},
+};
+
+// --- INTERNAL HELPERS ---
+
+static const size_t STATIC_COUNT = 61;
+static const size_t ENTRY_OVERHEAD = 32; // RFC 7541 section 4.1
+
+// The code is canonical: within one length, codes are consecutive in symbol order.
+// Decoding walks the lengths and checks whether the collected bits fall in that range.
+struct HuffmanDecodeTable {
+    uint32_t first[31] = {};  // First code of each length
+    uint16_t count[31] = {};  // Codes of each length
+    uint16_t offset[31] = {}; // Index of the first symbol of each length in symbols
+    uint8_t symbols[256] = {};
+
+    HuffmanDecodeTable() {
+        int n = 0;
+        for (int len = 5; len <= 30; len++) {
+            offset[len] = (uint16_t)n;
+            for (int s = 0; s < 256; s++) {
+                if (HUFFMAN_BITS[s] != len) continue;
+                if (count[len] == 0) first[len] = HUFFMAN_CODES[s];
+                count[len]++;
+                symbols[n++] = (uint8_t)s;
+            }
+        }
+    }
+};
+
+static void encode_int(uint64_t value, int prefix_bits, uint8_t first_byte, std::string& out) {
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    if (value < max_prefix) {
+        out += (char)(first_byte | value);
+        return;
+    }
+    out += (char)(first_byte | max_prefix);
+    value -= max_prefix;
+    while (value >= 128) {
+        out += (char)(0x80 | (value & 0x7f));
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+static bool decode_int(const uint8_t*& p, const uint8_t* end, int prefix_bits, uint64_t& value) {
+    if (p >= end) return false;
+    uint64_t max_prefix = (1u << prefix_bits) - 1;
+    value = *p++ & max_prefix;
+    if (value < max_prefix) return true;
+
+    for (int shift = 0; p < end && shift <= 56; shift += 7) {
+        uint8_t b = *p++;
+        value += (uint64_t)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+static void encode_string(const std::string& s, std::string& out) {
+    size_t packed = huffman_length(s);
+    if (packed < s.size()) {
+        encode_int(packed, 7, 0x80, out);
+        huffman_encode(s, out);
+    } else {
+        encode_int(s.size(), 7, 0x00, out);
+        out += s;
+    }
+}
+
+static bool decode_string(const uint8_t*& p, const uint8_t* end, std::string& out) {
+    if (p >= end) return false;
+    bool huffman = (*p & 0x80) != 0;
+    uint64_t len;
+    if (!decode_int(p, end, 7, len) || len > (uint64_t)(end - p)) return false;
+
+    out.clear();
+    bool ok = huffman ? huffman_decode(p, (size_t)len, out) : (out.assign((const char*)p, (size_t)len), true);
+    p += len;
+    return ok;
+}
+
+// --- HUFFMAN ---
+
+size_t huffman_length(const std::string& s) {
+    uint64_t bits = 0;
+    for (unsigned char c : s) bits += HUFFMAN_BITS[c];
+    return (size_t)((bits + 7) / 8);
+}
+
+void huffman_encode(const std::string& s, std::string& out) {
+    uint64_t acc = 0;
+    int bits = 0;
+    for (unsigned char c : s) {
+        acc = (acc << HUFFMAN_BITS[c]) | HUFFMAN_CODES[c];
+        bits += HUFFMAN_BITS[c];
+        while (bits >= 8) {
+            bits -= 8;
+            out += (char)(acc >> bits);
+        }
+    }
+    // Pad with the most significant bits of EOS (all ones)
+    if (bits > 0) out += (char)((acc << (8 - bits)) | (0xff >> bits));
+}
+
+bool huffman_decode(const uint8_t* data, size_t len, std::string& out) {
+    static const HuffmanDecodeTable t;
+
+    uint32_t code = 0;
+    int bits = 0;
+    for (size_t i = 0; i < len; i++) {
+        for (int b = 7; b >= 0; b--) {
+            code = (code << 1) | ((data[i] >> b) & 1);
+            bits++;
+            if (bits < 5) continue;
+            if (bits > 30) return false; // EOS or garbage
+            if (code - t.first[bits] < t.count[bits]) {
+                out += (char)t.symbols[t.offset[bits] + (code - t.first[bits])];
+                code = 0;
+                bits = 0;
+            }
+        }
+    }
+    // Leftover must be a short, all-ones padding
+    return bits < 8 && code == (1u << bits) - 1;
+}
+
+// --- CLASS METHODS ---
+
+void HpackTable::evict(size_t room) {
+    while (!entries.empty() && used + room > max) {
+        used -= entries.back().first.size() + entries.back().second.size() + ENTRY_OVERHEAD;
+        entries.pop_back();
+    }
+}
+
+const std::pair<std::string, std::string>* HpackTable::get(size_t index) const {
+    static std::pair<std::string, std::string> static_entries[STATIC_COUNT];
+    static bool filled = [] {
+        for (size_t i = 0; i < STATIC_COUNT; i++) static_entries[i] = {STATIC_TABLE[i][0], STATIC_TABLE[i][1]};
+        return true;
+    }();
+    (void)filled;
+
+    if (index == 0) return nullptr;
+    if (index <= STATIC_COUNT) return &static_entries[index - 1];
+    index -= STATIC_COUNT + 1;
+    return index < entries.size() ? &entries[index] : nullptr;
+}
+
+void HpackTable::add(const std::string& name, const std::string& value) {
+    size_t size = name.size() + value.size() + ENTRY_OVERHEAD;
+    evict(size);
+    // An entry larger than the whole table just empties it
+    if (size > max) return;
+    entries.emplace_front(name, value);
+    used += size;
+}
+
+void HpackTable::resize(size_t max_size) {
+    max = max_size;
+    evict(0);
+}
+
+long HpackTable::find(const std::string& name, const std::string& value, bool dynamic) const {
+    long name_match = 0;
+    for (size_t i = 0; i < STATIC_COUNT; i++) {
+        if (name != STATIC_TABLE[i][0]) continue;
+        if (value == STATIC_TABLE[i][1]) return (long)i + 1;
+        if (!name_match) name_match = -((long)i + 1);
+    }
+    for (size_t i = 0; dynamic && i < entries.size(); i++) {
+        if (entries[i].first != name) continue;
+        long index = (long)(STATIC_COUNT + 1 + i);
+        if (entries[i].second == value) return index;
+        if (!name_match) name_match = -index;
+    }
+    return name_match;
+}
+
+void HpackEncoder::set_max_table_size(size_t size) {
+    // Never grow past the default, a bigger table would only hold more stale entries
+    if (size > 4096) size = 4096;
+    if (size == table.max_size()) return;
+    pending_resize = size;
+}
+
+void HpackEncoder::encode(const HeaderList& headers, std::string& out, bool indexing) {
+    if (indexing && pending_resize != SIZE_MAX) {
+        table.resize(pending_resize);
+        encode_int(pending_resize, 5, 0x20, out);
+        pending_resize = SIZE_MAX;
+    }
+
+    for (const auto& [name, value] : headers) {
+        long index = table.find(name, value, indexing);
+        if (index > 0) {
+            encode_int((uint64_t)index, 7, 0x80, out); // Indexed field
+            continue;
+        }
+        // Literal with incremental indexing so the next request can refer to it, or without
+        uint64_t name_index = index < 0 ? (uint64_t)-index : 0;
+        if (indexing) encode_int(name_index, 6, 0x40, out);
+        else encode_int(name_index, 4, 0x00, out);
+        if (index == 0) encode_string(name, out);
+        encode_string(value, out);
+        if (indexing) table.add(name, value);
+    }
+}
+
+bool HpackDecoder::decode(const uint8_t* data, size_t len, HeaderList& out) {
+    const uint8_t* p = data;
+    const uint8_t* end = data + len;
+    std::string name, value;
+
+    while (p < end) {
+        uint8_t b = *p;
+        uint64_t index;
+
+        if (b & 0x80) {
+            // Indexed field
+            if (!decode_int(p, end, 7, index)) return false;
+            const auto* entry = table.get((size_t)index);
+            if (!entry) return false;
+            out.push_back(*entry);
+            continue;
+        }
+        if ((b & 0xe0) == 0x20) {
+            // Dynamic table size update, we announce the default 4096
+            if (!decode_int(p, end, 5, index) || index > 4096) return false;
+            table.resize((size_t)index);
+            continue;
+        }
+
+        // Literal: with incremental indexing (01), without (0000) or never indexed (0001)
+        bool indexing = (b & 0xc0) == 0x40;
+        if (!decode_int(p, end, indexing ? 6 : 4, index)) return false;
+        if (index) {
+            const auto* entry = table.get((size_t)index);
+            if (!entry) return false;
+            name = entry->first;
+        } else if (!decode_string(p, end, name)) {
+            return false;
+        }
+        if (!decode_string(p, end, value)) return false;
+
+        if (indexing) table.add(name, value);
+        out.emplace_back(name, value);
+    }
+    return true;
+}
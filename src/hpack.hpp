@@ -0,0 +1,61 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <utility>
+#include <vector>
+
+// RFC 7541 header compression for the HTTP/2 backend. Both sides keep a dynamic table in
+// sync with the peer, so the big browser header set (sec-ch-ua, user-agent, referer ...)
+// costs a few bytes once it has been sent on a connection.
+
+using HeaderList = std::vector<std::pair<std::string, std::string>>;
+
+class HpackTable {
+private:
+    std::deque<std::pair<std::string, std::string>> entries; // Newest first
+    size_t used = 0;
+    size_t max = 4096;
+
+    void evict(size_t room);
+
+public:
+    // Index 1..61 is the static table, 62 and up the dynamic one
+    const std::pair<std::string, std::string>* get(size_t index) const;
+    void add(const std::string& name, const std::string& value);
+    void resize(size_t max_size);
+    size_t max_size() const { return max; }
+
+    // Best match for a header: 0 if none, negative if only the name matched.
+    // dynamic = false only looks at the static table
+    long find(const std::string& name, const std::string& value, bool dynamic = true) const;
+};
+
+class HpackEncoder {
+private:
+    HpackTable table;
+    size_t pending_resize = SIZE_MAX; // Table size change to announce in the next block
+
+public:
+    // Peer's SETTINGS_HEADER_TABLE_SIZE
+    void set_max_table_size(size_t size);
+
+    // Appends the header block for headers (names must be lower case). Without indexing the
+    // block neither reads nor changes the dynamic table, so it stays valid in any send order
+    void encode(const HeaderList& headers, std::string& out, bool indexing = true);
+};
+
+class HpackDecoder {
+private:
+    HpackTable table;
+
+public:
+    // Decodes one complete header block, false on a compression error (fatal for the connection)
+    bool decode(const uint8_t* data, size_t len, HeaderList& out);
+};
+
+// Huffman coding from RFC 7541 Appendix B, exposed for the string literals
+size_t huffman_length(const std::string& s);
+void huffman_encode(const std::string& s, std::string& out);
+bool huffman_decode(const uint8_t* data, size_t len, std::string& out);
@@ -0,0 +1,312 @@
+#include "http2.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+// Frame types and flags from RFC 9113 section 6
+enum : uint8_t {
+    DATA = 0x0, HEADERS = 0x1, RST_STREAM = 0x3, SETTINGS = 0x4, PUSH_PROMISE = 0x5,
+    PING = 0x6, GOAWAY = 0x7, WINDOW_UPDATE = 0x8, CONTINUATION = 0x9
+};
+enum : uint8_t { END_STREAM = 0x1, ACK = 0x1, END_HEADERS = 0x4, PADDED = 0x8, PRIORITY = 0x20 };
+enum : uint16_t { HEADER_TABLE_SIZE = 0x1, ENABLE_PUSH = 0x2, MAX_CONCURRENT_STREAMS = 0x3, INITIAL_WINDOW_SIZE = 0x4, MAX_FRAME_SIZE = 0x5 };
+const uint32_t CANCEL = 0x8;
+
+const char PREFACE[] = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+
+// --- INTERNAL HELPERS ---
+
+static uint32_t read32(const uint8_t* p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void put32(char* p, uint32_t v) {
+    p[0] = (char)(v >> 24);
+    p[1] = (char)(v >> 16);
+    p[2] = (char)(v >> 8);
+    p[3] = (char)v;
+}
+
+static void append_frame(std::string& out, uint8_t type, uint8_t flags, uint32_t stream, const char* payload, size_t len) {
+    char head[9];
+    Http2Session::frame_header(head, (uint32_t)len, type, flags, stream);
+    out.append(head, 9);
+    if (len) out.append(payload, len);
+}
+
+static void append_setting(std::string& out, uint16_t id, uint32_t value) {
+    char s[6] = {(char)(id >> 8), (char)id};
+    put32(s + 2, value);
+    out.append(s, 6);
+}
+
+// --- CLASS METHODS ---
+
+void Http2Session::frame_header(char* out, uint32_t len, uint8_t type, uint8_t flags, uint32_t stream) {
+    out[0] = (char)(len >> 16);
+    out[1] = (char)(len >> 8);
+    out[2] = (char)len;
+    out[3] = (char)type;
+    out[4] = (char)flags;
+    put32(out + 5, stream & 0x7fffffff);
+}
+
+Http2Session::Http2Session() {
+    static std::atomic<uint64_t> sessions{0};
+    serial = ++sessions;
+    streams.reserve(16);
+}
+
+Http2Session::~Http2Session() {
+    for (Http2Stream* s : streams) s->reset = true;
+}
+
+void Http2Session::start(std::string& out) {
+    out.append(PREFACE, sizeof(PREFACE) - 1);
+
+    std::string settings;
+    append_setting(settings, ENABLE_PUSH, 0);
+    append_setting(settings, INITIAL_WINDOW_SIZE, RECV_WINDOW);
+    append_frame(out, SETTINGS, 0, 0, settings.data(), settings.size());
+
+    // The connection window starts at 65535 regardless of SETTINGS
+    window_update(0, RECV_WINDOW - 65535, out);
+}
+
+void Http2Session::window_update(uint32_t id, uint32_t increment, std::string& out) {
+    char p[4];
+    put32(p, increment & 0x7fffffff);
+    append_frame(out, WINDOW_UPDATE, 0, id, p, 4);
+}
+
+Http2Stream* Http2Session::find(uint32_t id) {
+    for (Http2Stream* s : streams) {
+        if (s->id == id) return s;
+    }
+    return nullptr;
+}
+
+bool Http2Session::render_headers(const HeaderList& headers, bool end_stream, std::string& out) {
+    // A block rendered ahead of time (the fire request) may still be waiting. Anything rendered
+    // meanwhile stays off the dynamic table so both blocks decode in either order
+    bool indexing = !static_only && unsent_blocks == 0;
+    std::string fragment;
+    encoder.encode(headers, fragment, indexing);
+    if (indexing) unsent_blocks++;
+
+    size_t pos = 0;
+    do {
+        size_t n = std::min(fragment.size() - pos, (size_t)FRAME_MAX);
+        uint8_t flags = pos + n == fragment.size() ? END_HEADERS : 0;
+        if (pos == 0 && end_stream) flags |= END_STREAM;
+        append_frame(out, pos == 0 ? HEADERS : CONTINUATION, flags, 0, fragment.data() + pos, n);
+        pos += n;
+    } while (pos < fragment.size());
+    return indexing;
+}
+
+void Http2Session::block_dropped() {
+    // The encoder added entries the server never saw, stop using the dynamic table
+    unsent_blocks--;
+    static_only = true;
+}
+
+void Http2Session::open(Http2Stream& stream, char* frames, size_t len) {
+    stream.id = next_id;
+    next_id += 2;
+    stream.send_window = peer_initial_window;
+    streams.push_back(&stream);
+
+    for (size_t pos = 0; pos + 9 <= len; ) {
+        uint32_t flen = ((uint32_t)(uint8_t)frames[pos] << 16) | ((uint32_t)(uint8_t)frames[pos + 1] << 8) | (uint8_t)frames[pos + 2];
+        put32(frames + pos + 5, stream.id);
+        pos += 9 + flen;
+    }
+}
+
+void Http2Session::close(Http2Stream& stream, std::string& out) {
+    if (stream.id && !stream.ended && !stream.reset && !away) {
+        char p[4];
+        put32(p, CANCEL);
+        append_frame(out, RST_STREAM, 0, stream.id, p, 4);
+    }
+    forget(stream);
+}
+
+void Http2Session::forget(Http2Stream& stream) {
+    streams.erase(std::remove(streams.begin(), streams.end(), &stream), streams.end());
+}
+
+int64_t Http2Session::send_window(const Http2Stream& stream) const {
+    return std::min(stream.send_window, conn_send_window);
+}
+
+void Http2Session::consume_window(Http2Stream& stream, size_t n) {
+    stream.send_window -= (int64_t)n;
+    conn_send_window -= (int64_t)n;
+}
+
+void Http2Session::ping(std::string& out) {
+    char payload[8] = {'i', 't', 'u', 'd', 'e', 'r', 's', '!'};
+    append_frame(out, PING, 0, 0, payload, 8);
+}
+
+bool Http2Session::finish_block() {
+    HeaderList fields;
+    // Decode even for streams we dropped, the HPACK state is shared by the whole connection
+    if (!decoder.decode((const uint8_t*)block.data(), block.size(), fields)) return false;
+    block.clear();
+
+    Http2Stream* s = find(block_stream);
+    if (!s) return true;
+
+    int status = 0;
+    for (const auto& [name, value] : fields) {
+        if (name == ":status") status = std::atoi(value.c_str());
+    }
+    if (!s->has_head && status >= 100 && status < 200 && !block_end_stream) return true; // Informational
+
+    if (!s->has_head) {
+        s->status = status;
+        for (auto& f : fields) {
+            if (!f.first.empty() && f.first[0] != ':') s->headers.push_back(std::move(f));
+        }
+        s->has_head = true;
+    }
+    // Otherwise these are trailers, nothing here needs them
+    if (block_end_stream) s->ended = true;
+    return true;
+}
+
+bool Http2Session::consume(std::string& in, std::string& out) {
+    size_t pos = 0;
+    while (in.size() - pos >= 9) {
+        const uint8_t* h = (const uint8_t*)in.data() + pos;
+        uint32_t len = ((uint32_t)h[0] << 16) | ((uint32_t)h[1] << 8) | h[2];
+        uint8_t type = h[3], flags = h[4];
+        uint32_t id = read32(h + 5) & 0x7fffffff;
+        if (len > FRAME_MAX) return false;
+        if (in.size() - pos < 9 + (size_t)len) break;
+
+        const uint8_t* p = h + 9;
+        pos += 9 + len;
+
+        // A header block must not be interrupted by any other frame
+        if (block_stream && (type != CONTINUATION || id != block_stream)) return false;
+
+        switch (type) {
+            case DATA: {
+                size_t pad = 0, skip = 0;
+                if (flags & PADDED) {
+                    if (len < 1) return false;
+                    pad = p[0];
+                    skip = 1;
+                }
+                if (skip + pad > len) return false;
+
+                // Flow control counts the whole frame, hand the credit back in large steps
+                recv_unacked += len;
+                if (recv_unacked >= RECV_WINDOW / 2) {
+                    window_update(0, (uint32_t)recv_unacked, out);
+                    recv_unacked = 0;
+                }
+
+                Http2Stream* s = find(id);
+                if (!s) break;
+                s->data.append((const char*)p + skip, len - skip - pad);
+                s->recv_unacked += len;
+                if (s->recv_unacked >= RECV_WINDOW / 2 && !(flags & END_STREAM)) {
+                    window_update(id, (uint32_t)s->recv_unacked, out);
+                    s->recv_unacked = 0;
+                }
+                if (flags & END_STREAM) s->ended = true;
+                break;
+            }
+            case HEADERS:
+            case CONTINUATION: {
+                size_t skip = 0, pad = 0;
+                if (type == HEADERS) {
+                    if (flags & PADDED) {
+                        if (len < 1) return false;
+                        pad = p[0];
+                        skip = 1;
+                    }
+                    if (flags & PRIORITY) skip += 5;
+                    if (skip + pad > len) return false;
+                    block_end_stream = (flags & END_STREAM) != 0;
+                } else if (!block_stream) {
+                    return false;
+                }
+                block.append((const char*)p + skip, len - skip - pad);
+                block_stream = id;
+                if (flags & END_HEADERS) {
+                    if (!finish_block()) return false;
+                    block_stream = 0;
+                }
+                break;
+            }
+            case RST_STREAM:
+                if (Http2Stream* s = find(id)) {
+                    s->reset = true;
+                    s->error = len >= 4 ? read32(p) : 0;
+                }
+                break;
+            case SETTINGS:
+                // Malformed settings are a connection error (RFC 9113 section 6.5), checked before any is applied
+                if (id != 0 || (flags & ACK ? len != 0 : len % 6 != 0)) return false;
+                if (flags & ACK) break;
+                for (uint32_t i = 0; i < len; i += 6) {
+                    uint16_t key = (uint16_t)((p[i] << 8) | p[i + 1]);
+                    uint32_t value = read32(p + i + 2);
+                    if (key == ENABLE_PUSH && value > 1) return false;
+                    if (key == INITIAL_WINDOW_SIZE && value > 0x7fffffff) return false;
+                    if (key == MAX_FRAME_SIZE && (value < FRAME_MAX || value > 0xffffff)) return false;
+                }
+                for (uint32_t i = 0; i < len; i += 6) {
+                    uint16_t key = (uint16_t)((p[i] << 8) | p[i + 1]);
+                    uint32_t value = read32(p + i + 2);
+                    if (key == HEADER_TABLE_SIZE) encoder.set_max_table_size(value);
+                    if (key == MAX_CONCURRENT_STREAMS) peer_max_streams = value;
+                    if (key == INITIAL_WINDOW_SIZE) {
+                        // Applies retroactively to every open stream
+                        for (Http2Stream* s : streams) s->send_window += (int64_t)value - peer_initial_window;
+                        peer_initial_window = value;
+                    }
+                }
+                append_frame(out, SETTINGS, ACK, 0, nullptr, 0);
+                break;
+            case PUSH_PROMISE:
+                return false; // Disabled in our SETTINGS
+            case PING:
+                if (len != 8) return false;
+                if (flags & ACK) pings_acked++;
+                else append_frame(out, PING, ACK, 0, (const char*)p, 8);
+                break;
+            case GOAWAY: {
+                away = true;
+                uint32_t last = len >= 4 ? read32(p) & 0x7fffffff : 0;
+                away_error = len >= 8 ? read32(p + 4) : 0;
+                // Streams above last were never processed, the caller may retry them elsewhere
+                for (Http2Stream* s : streams) {
+                    if (s->id > last) {
+                        s->reset = true;
+                        s->error = away_error;
+                    }
+                }
+                break;
+            }
+            case WINDOW_UPDATE: {
+                if (len != 4) return false;
+                uint32_t inc = read32(p) & 0x7fffffff;
+                if (id == 0) conn_send_window += inc;
+                else if (Http2Stream* s = find(id)) s->send_window += inc;
+                break;
+            }
+            default:
+                break; // Unknown frame types must be ignored
+        }
+    }
+    in.erase(0, pos);
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "hpack.hpp"
+
+// HTTP/2 framing (RFC 9113) for one connection. The session does no I/O: the owner feeds it
+// received bytes and writes out whatever frames it queues, so it works on top of any socket.
+
+// Per-request view of a stream, owned by the request and registered with the session
+struct Http2Stream {
+    uint32_t id = 0;
+    int status = 0;
+    HeaderList headers;
+    std::string data;
+    bool has_head = false;
+    bool ended = false;      // END_STREAM received
+    bool reset = false;      // RST_STREAM received or the stream died with the connection
+    uint32_t error = 0;      // RST_STREAM / GOAWAY error code
+    int64_t send_window = 0;
+    uint64_t recv_unacked = 0; // Stream-level bytes not yet returned with WINDOW_UPDATE
+};
+
+class Http2Session {
+private:
+    static const uint32_t FRAME_MAX = 16384;            // Both directions, we never raise it
+    static const uint32_t RECV_WINDOW = 16 * 1024 * 1024; // Announced for the connection and every stream
+
+    HpackEncoder encoder;
+    HpackDecoder decoder;
+    std::vector<Http2Stream*> streams; // Open streams, capacity reserved so opening one does not allocate
+    uint64_t serial;
+    uint32_t next_id = 1;
+    int64_t conn_send_window = 65535;
+    uint32_t peer_initial_window = 65535;
+    uint32_t peer_max_streams = 100;
+    uint64_t recv_unacked = 0;          // Connection-level bytes not yet returned with WINDOW_UPDATE
+    int unsent_blocks = 0;              // Indexed header blocks rendered but not on the wire yet
+    bool static_only = false;           // An indexed block was dropped, the dynamic table is out of sync
+    bool away = false;
+    uint32_t away_error = 0;
+    uint64_t pings_acked = 0;
+
+    // Header block being collected across HEADERS + CONTINUATION
+    std::string block;
+    uint32_t block_stream = 0;
+    bool block_end_stream = false;
+
+    Http2Stream* find(uint32_t id);
+    bool finish_block();
+    void window_update(uint32_t id, uint32_t increment, std::string& out);
+
+public:
+    Http2Session();
+    ~Http2Session(); // Streams still open are marked as reset
+
+    // Client preface, SETTINGS and the connection window, written right after the handshake
+    void start(std::string& out);
+
+    // Parses the complete frames at the front of in and erases them. Replies (SETTINGS and PING
+    // acks, WINDOW_UPDATEs) are appended to out. False on a connection error
+    bool consume(std::string& in, std::string& out);
+
+    // Renders the header block for a request as HEADERS (+ CONTINUATION) frames with stream id 0,
+    // the id is assigned when the request goes out. Returns whether the block uses the dynamic
+    // table, in which case it must be reported through block_sent() or block_dropped()
+    bool render_headers(const HeaderList& headers, bool end_stream, std::string& out);
+    void block_sent() { unsent_blocks--; }
+    void block_dropped();
+
+    // Registers a stream under the next free id and writes that id into its rendered frames
+    void open(Http2Stream& stream, char* frames, size_t len);
+    void close(Http2Stream& stream, std::string& out); // RST_STREAM(CANCEL) if it is still running
+    void forget(Http2Stream& stream);
+
+    // Flow control for request bodies
+    int64_t send_window(const Http2Stream& stream) const;
+    void consume_window(Http2Stream& stream, size_t n);
+
+    void ping(std::string& out);
+    uint64_t pongs() const { return pings_acked; }
+
+    // Unique per session, so a request can tell whether it was rendered for this one
+    uint64_t id() const { return serial; }
+    bool is_away() const { return away; }
+    bool can_open() const { return !away && streams.size() < peer_max_streams && next_id < 0x7fffffff; }
+
+    static void frame_header(char* out, uint32_t len, uint8_t type, uint8_t flags, uint32_t stream);
+    static size_t max_frame() { return FRAME_MAX; }
+};
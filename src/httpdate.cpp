@@ -0,0 +1,153 @@
+#include "httpdate.hpp"
+
+// --- INTERNAL HELPERS ---
+
+static const char* const SHORT_DAYS[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+static const char* const LONG_DAYS[] = {"Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday"};
+static const char MONTHS[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+// Reads the input left to right, every step fails once on a mismatch and stays failed
+struct DateCursor {
+    std::string_view s;
+    size_t pos = 0;
+    bool ok = true;
+
+    bool at_end() const { return pos >= s.size(); }
+
+    void expect(char c) {
+        if (ok && pos < s.size() && s[pos] == c) pos++;
+        else ok = false;
+    }
+
+    void expect(std::string_view word) {
+        if (ok && s.substr(pos, word.size()) == word) pos += word.size();
+        else ok = false;
+    }
+
+    int number(int count) {
+        int value = 0;
+        for (int i = 0; i < count && ok; i++, pos++) {
+            if (pos >= s.size() || s[pos] < '0' || s[pos] > '9') ok = false;
+            else value = value * 10 + (s[pos] - '0');
+        }
+        return value;
+    }
+
+    // 1-12, month names are case-sensitive like the grammar says
+    int month() {
+        if (!ok || pos + 3 > s.size()) { ok = false; return 0; }
+        for (int m = 0; m < 12; m++) {
+            if (s.compare(pos, 3, MONTHS + m * 3, 3) == 0) {
+                pos += 3;
+                return m + 1;
+            }
+        }
+        ok = false;
+        return 0;
+    }
+
+    void weekday(const char* const* names) {
+        if (!ok) return;
+        for (int d = 0; d < 7; d++) {
+            std::string_view name(names[d]);
+            if (s.substr(pos, name.size()) == name) {
+                pos += name.size();
+                return;
+            }
+        }
+        ok = false;
+    }
+
+    // HH:MM:SS, 60 seconds allowed for a leap second
+    void time_of_day(int& h, int& m, int& sec) {
+        h = number(2);
+        expect(':');
+        m = number(2);
+        expect(':');
+        sec = number(2);
+        if (h > 23 || m > 59 || sec > 60) ok = false;
+    }
+};
+
+static bool leap_year(int y) {
+    return (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+}
+
+static bool valid_day(int year, int month, int day) {
+    static const int DAYS_IN_MONTH[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12 || day < 1) return false;
+    return day <= DAYS_IN_MONTH[month - 1] + (month == 2 && leap_year(year) ? 1 : 0);
+}
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar (H. Hinnant's days_from_civil)
+static long long days_from_civil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    long long era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (long long)doe - 719468;
+}
+
+// --- PARSER ---
+
+std::time_t utc_from_civil(int year, int month, int day, int hour, int minute, int second) {
+    long long days = days_from_civil(year, (unsigned)month, (unsigned)day);
+    return (std::time_t)(days * 86400 + hour * 3600 + minute * 60 + second);
+}
+
+std::time_t parse_http_date(std::string_view value) {
+    // Leading and trailing whitespace is not part of the header value
+    while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+    while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+
+    DateCursor c{value};
+    int year = 0, month = 0, day = 0, h = 0, m = 0, s = 0;
+
+    if (value.size() > 3 && value[3] == ',') {
+        // IMF-fixdate: Sun, 06 Nov 1994 08:49:37 GMT
+        c.weekday(SHORT_DAYS);
+        c.expect(", ");
+        day = c.number(2);
+        c.expect(' ');
+        month = c.month();
+        c.expect(' ');
+        year = c.number(4);
+        c.expect(' ');
+        c.time_of_day(h, m, s);
+        c.expect(" GMT");
+    } else if (value.find(',') != std::string_view::npos) {
+        // RFC 850: Sunday, 06-Nov-94 08:49:37 GMT. Two digit years below 70 are 20xx, the
+        // rest 19xx (1970-2069), which covers every date this bot will ever see
+        c.weekday(LONG_DAYS);
+        c.expect(", ");
+        day = c.number(2);
+        c.expect('-');
+        month = c.month();
+        c.expect('-');
+        year = c.number(2);
+        year += year < 70 ? 2000 : 1900;
+        c.expect(' ');
+        c.time_of_day(h, m, s);
+        c.expect(" GMT");
+    } else {
+        // asctime: Sun Nov  6 08:49:37 1994, single digit days are padded with a space
+        c.weekday(SHORT_DAYS);
+        c.expect(' ');
+        month = c.month();
+        c.expect(' ');
+        if (!c.at_end() && c.s[c.pos] == ' ') {
+            c.pos++;
+            day = c.number(1);
+        } else {
+            day = c.number(2);
+        }
+        c.expect(' ');
+        c.time_of_day(h, m, s);
+        c.expect(' ');
+        year = c.number(4);
+    }
+
+    if (!c.ok || !c.at_end() || !valid_day(year, month, day)) return -1;
+    return utc_from_civil(year, month, day, h, m, s);
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <ctime>
+#include <string_view>
+
+// HTTP-date parsing (RFC 7231 7.1.1.1) without streams, locales or allocation. Accepts the
+// IMF-fixdate every current server sends and the two obsolete forms recipients must still read:
+//   Sun, 06 Nov 1994 08:49:37 GMT   (IMF-fixdate)
+//   Sunday, 06-Nov-94 08:49:37 GMT  (RFC 850, two digit year)
+//   Sun Nov  6 08:49:37 1994        (asctime)
+// Returns seconds since the epoch, or -1 if value is not a valid date in one of these forms.
+std::time_t parse_http_date(std::string_view value);
+
+// Seconds since the epoch of a UTC calendar time, without going through timegm/_mkgmtime.
+// Month is 1-12; out of range fields are not normalized
+std::time_t utc_from_civil(int year, int month, int day, int hour, int minute, int second);
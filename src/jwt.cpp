@@ -0,0 +1,72 @@
+#include "jwt.hpp"
+#include <cstdlib>
+#include "../include/nlohmann_json.hpp"
+
+// --- INTERNAL HELPERS ---
+
+static int base64url_value(char c) {
+    if (c >= 'A' && c <= 'Z') return c - 'A';
+    if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+    if (c >= '0' && c <= '9') return c - '0' + 52;
+    if (c == '-' || c == '+') return 62;
+    if (c == '_' || c == '/') return 63;
+    return -1;
+}
+
+// Numeric claim, servers differ in sending it as an integer, a float or a string
+static long long read_time_claim(const nlohmann::json& payload, const char* name) {
+    auto it = payload.find(name);
+    if (it == payload.end()) return 0;
+    if (it->is_number()) return (long long)it->get<double>();
+    if (it->is_string()) {
+        const std::string& s = it->get_ref<const std::string&>();
+        char* end = nullptr;
+        long long v = std::strtoll(s.c_str(), &end, 10);
+        return (end && *end == '\0') ? v : 0;
+    }
+    return 0;
+}
+
+// --- DECODING ---
+
+bool base64url_decode(std::string_view in, std::string& out) {
+    out.clear();
+    out.reserve(in.size() * 3 / 4);
+    unsigned buffer = 0;
+    int bits = 0;
+    for (char c : in) {
+        if (c == '=') break;
+        int v = base64url_value(c);
+        if (v < 0) return false;
+        buffer = (buffer << 6) | (unsigned)v;
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back((char)((buffer >> bits) & 0xFF));
+        }
+    }
+    return true;
+}
+
+bool decode_jwt(std::string_view token, JwtClaims& out) {
+    out = JwtClaims();
+    while (!token.empty() && (token.front() == ' ' || token.front() == '"' || token.front() == '\r' || token.front() == '\n')) token.remove_prefix(1);
+    while (!token.empty() && (token.back() == ' ' || token.back() == '"' || token.back() == '\r' || token.back() == '\n')) token.remove_suffix(1);
+    if (token.substr(0, 7) == "Bearer ") token.remove_prefix(7);
+
+    size_t first = token.find('.');
+    if (first == std::string_view::npos) return false;
+    size_t second = token.find('.', first + 1);
+    if (second == std::string_view::npos) return false;
+
+    std::string payload;
+    if (!base64url_decode(token.substr(first + 1, second - first - 1), payload)) return false;
+
+    nlohmann::json claims = nlohmann::json::parse(payload, nullptr, false);
+    if (claims.is_discarded() || !claims.is_object()) return false;
+
+    out.exp = read_time_claim(claims, "exp");
+    out.iat = read_time_claim(claims, "iat");
+    if (claims.contains("sub") && claims["sub"].is_string()) out.sub = claims["sub"].get<std::string>();
+    return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Registered claims of a JWT, read from its payload without checking the signature (only the
+// server can do that, the bot just needs to know how long its token lasts)
+struct JwtClaims {
+    long long exp = 0; // Expiry, seconds since the epoch, 0 if the token has none
+    long long iat = 0; // Issued at, 0 if missing
+    std::string sub;
+
+    // Seconds between issue and expiry, 0 if either is unknown
+    long long lifetime() const { return (exp > 0 && iat > 0 && exp > iat) ? exp - iat : 0; }
+};
+
+// Decodes the payload of a compact JWT ("header.payload.signature"). A "Bearer " prefix and
+// surrounding quotes or whitespace are skipped. False if it is not a JWT with a JSON payload
+bool decode_jwt(std::string_view token, JwtClaims& out);
+
+// base64url (RFC 4648 section 5) without padding, as JWTs use it. False on a character outside the alphabet
+bool base64url_decode(std::string_view in, std::string& out);
@@ -0,0 +1,1004 @@
+#ifdef __linux__
+#include "linux_transport.hpp"
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+const int IO_TIMEOUT_MS = 30000; // Same as the WinHTTP send/receive defaults
+const int MAX_REDIRECTS = 10;
+const size_t STREAM_STEP = 16384; // A streamed body is looked at after every TLS record
+
+// --- INTERNAL HELPERS ---
+
+static std::string lower_case(std::string s) {
+    for (char& c : s) c = (char)std::tolower((unsigned char)c);
+    return s;
+}
+
+static std::string ssl_error_string() {
+    unsigned long code = ERR_get_error();
+    if (code == 0) return std::strerror(errno);
+    char buf[256];
+    ERR_error_string_n(code, buf, sizeof(buf));
+    return buf;
+}
+
+// --- CONNECTION ---
+
+LinuxConnection::LinuxConnection(LinuxTransport& transport, const std::string& host, int port)
+    : transport(transport), host_name(host), port(port), timeout_ms(IO_TIMEOUT_MS) {}
+
+LinuxConnection::~LinuxConnection() {
+    close();
+}
+
+void LinuxConnection::close() {
+    h2.reset(); // Marks its streams as reset
+    if (ssl) {
+        // An unclean close makes OpenSSL mark the session as not resumable
+        SSL_shutdown(ssl);
+        SSL_free(ssl);
+        ssl = nullptr;
+    }
+    if (fd >= 0) {
+        transport.loop().unwatch(fd);
+        ::close(fd);
+    }
+    fd = -1;
+    idle = false;
+    inbuf.clear();
+
+    // Whoever waits on this socket has to learn that it is gone
+    if (!readers.empty() || on_pong) dispatch_readers();
+}
+
+// Other exchanges on the transport keep running while this one waits
+bool LinuxConnection::wait(uint32_t events, int timeout_ms) {
+    bool ready = transport.loop().wait(fd, events, timeout_ms);
+    // The blocking wait took over the socket's watch, hand it back to async readers
+    watch_readers();
+    wait_timed_out = !ready;
+    if (!ready) err = "Operation timed out.";
+    return ready;
+}
+
+bool LinuxConnection::wait_ssl(int ret) {
+    switch (SSL_get_error(ssl, ret)) {
+        case SSL_ERROR_WANT_READ:  return wait(EPOLLIN, timeout_ms);
+        case SSL_ERROR_WANT_WRITE: return wait(EPOLLOUT, timeout_ms);
+        case SSL_ERROR_ZERO_RETURN:
+            err = "Connection closed by server.";
+            return false;
+        default:
+            err = ssl_error_string();
+            return false;
+    }
+}
+
+// An idle keep-alive socket that has anything to read was closed (or is being closed) by the server.
+// Post-handshake TLS messages such as session tickets are consumed without counting as data.
+bool LinuxConnection::is_stale() {
+    if (h2) {
+        // Other streams may be running, so process whatever came in instead of discarding it
+        int got = read_available();
+        if (got < 0 || (got > 0 && !process_h2())) return true;
+        if (got > 0) dispatch_readers();
+        return !h2 || !h2->can_open();
+    }
+    if (!inbuf.empty()) return true;
+    if (!idle) return false;
+
+    char c;
+    ERR_clear_error();
+    int n = SSL_read(ssl, &c, 1);
+    return n > 0 || SSL_get_error(ssl, n) != SSL_ERROR_WANT_READ;
+}
+
+bool LinuxConnection::ensure_open() {
+    if (ssl && !is_stale()) return true;
+    close();
+
+    auto t1 = std::chrono::steady_clock::now();
+
+    std::vector<ResolvedAddress> addrs = transport.addresses(host_name, port);
+    if (addrs.empty()) {
+        err = "Name resolution failed for " + host_name;
+        return false;
+    }
+
+    for (const ResolvedAddress& a : addrs) {
+        fd = ::socket(a.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0) continue;
+
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        if (transport.is_low_priority()) {
+            // DSCP CS1 (lower effort): the local qdisc and the path queue it behind normal traffic
+            int tos = 0x20;
+            if (a.addr.ss_family == AF_INET6) setsockopt(fd, IPPROTO_IPV6, IPV6_TCLASS, &tos, sizeof(tos));
+            else setsockopt(fd, IPPROTO_IP, IP_TOS, &tos, sizeof(tos));
+        }
+
+        if (::connect(fd, (const sockaddr*)&a.addr, a.len) == 0 ||
+            (errno == EINPROGRESS && wait(EPOLLOUT, timeout_ms))) {
+            int so_err = 0;
+            socklen_t len = sizeof(so_err);
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_err, &len);
+            if (so_err == 0) break;
+            err = std::string("Cannot connect to server: ") + std::strerror(so_err);
+        } else if (errno != EINPROGRESS) {
+            err = std::string("Cannot connect to server: ") + std::strerror(errno);
+        }
+        transport.loop().unwatch(fd);
+        ::close(fd);
+        fd = -1;
+    }
+    if (fd < 0) return false;
+
+    ssl = SSL_new(transport.context());
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, host_name.c_str());
+    SSL_set1_host(ssl, host_name.c_str());
+    SSL_set_app_data(ssl, this);
+
+    // Offer the ticket from an earlier connection, a resumed handshake skips the certificate exchange
+    if (SSL_SESSION* cached = transport.session_for(session_key())) SSL_set_session(ssl, cached);
+
+    while (true) {
+        int ret = SSL_connect(ssl);
+        if (ret == 1) break;
+        if (!wait_ssl(ret)) {
+            err = "SSL/TLS handshake error: " + err;
+            close();
+            return false;
+        }
+    }
+
+    // ALPN decides between one multiplexed HTTP/2 session and plain HTTP/1.1
+    const unsigned char* alpn = nullptr;
+    unsigned alpn_len = 0;
+    SSL_get0_alpn_selected(ssl, &alpn, &alpn_len);
+    if (alpn_len == 2 && std::memcmp(alpn, "h2", 2) == 0) {
+        h2 = std::make_unique<Http2Session>();
+        std::string preface;
+        h2->start(preface);
+        if (!write_all(preface.data(), preface.size())) {
+            err = "HTTP/2 setup failed: " + err;
+            close();
+            return false;
+        }
+    }
+
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+    transport.record_handshake(session_key(), ms, SSL_session_reused(ssl) == 1, h2 ? "h2" : "http/1.1");
+    return true;
+}
+
+bool LinuxConnection::write_all(const char* data, size_t len) {
+    while (len > 0) {
+        int n = SSL_write(ssl, data, (int)len);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+        } else if (!wait_ssl(n)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t LinuxConnection::read_into(char* dst, size_t cap) {
+    if (!ssl) {
+        err = "Connection is closed.";
+        return 0;
+    }
+    int want = (int)std::min(cap, (size_t)INT32_MAX);
+    while (true) {
+        int n = SSL_read(ssl, dst, want);
+        if (n > 0) return (size_t)n;
+        int code = SSL_get_error(ssl, n);
+        if (code == SSL_ERROR_ZERO_RETURN || (code == SSL_ERROR_SYSCALL && errno == 0)) {
+            err = "Connection closed by server.";
+            return 0;
+        }
+        if (!wait_ssl(n)) return 0;
+    }
+}
+
+bool LinuxConnection::read_some() {
+    char buf[16384];
+    size_t n = read_into(buf, sizeof(buf));
+    if (n == 0) return false;
+    inbuf.append(buf, n);
+    if (!h2) return true;
+    // The frames may belong to other streams, their requests get to look at them too
+    if (!process_h2()) return false;
+    dispatch_readers();
+    return true;
+}
+
+bool LinuxConnection::process_h2() {
+    std::string out;
+    if (!h2->consume(inbuf, out)) {
+        err = "HTTP/2 protocol error.";
+        close();
+        return false;
+    }
+    if (!out.empty() && !write_all(out.data(), out.size())) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void LinuxConnection::pump() {
+    if (ssl) {
+        int got = read_available();
+        if (got < 0) close();
+        else if (got > 0 && h2) process_h2();
+    }
+    dispatch_readers();
+}
+
+void LinuxConnection::dispatch_readers() {
+    // A reader may close the connection or start another exchange on it, the running pass repeats
+    if (dispatching) {
+        redispatch = true;
+        return;
+    }
+    dispatching = true;
+    do {
+        redispatch = false;
+        std::vector<LinuxRequest*> waiting = readers;
+        for (LinuxRequest* r : waiting) {
+            if (std::find(readers.begin(), readers.end(), r) == readers.end()) continue;
+            if (r->on_readable(*this)) remove_reader(r);
+        }
+        if (on_pong && (!h2 || h2->pongs() > pongs_seen)) {
+            bool ok = h2 != nullptr;
+            std::function<void(bool)> done = std::move(on_pong);
+            on_pong = nullptr;
+            done(ok);
+        }
+    } while (redispatch);
+    dispatching = false;
+    watch_readers();
+}
+
+void LinuxConnection::watch_readers() {
+    if (dispatching || fd < 0 || (readers.empty() && !on_pong)) return;
+    transport.loop().watch(fd, EPOLLIN, [this](uint32_t) { pump(); });
+}
+
+void LinuxConnection::add_reader(LinuxRequest* request) {
+    readers.push_back(request);
+    // The response may already be buffered, in which case no readiness event would come
+    pump();
+}
+
+void LinuxConnection::remove_reader(LinuxRequest* request) {
+    readers.erase(std::remove(readers.begin(), readers.end(), request), readers.end());
+}
+
+bool LinuxConnection::ping_async(std::function<void(bool ok)> done) {
+    if (!h2 || !ssl || on_pong || h2->is_away()) return false;
+
+    std::string frame;
+    h2->ping(frame);
+    pongs_seen = h2->pongs();
+    if (!write_all(frame.data(), frame.size())) {
+        close();
+        done(false);
+        return true;
+    }
+    on_pong = std::move(done);
+    pump();
+    return true;
+}
+
+int LinuxConnection::read_available() {
+    char buf[16384];
+    int got = 0;
+    while (true) {
+        ERR_clear_error();
+        int n = SSL_read(ssl, buf, sizeof(buf));
+        if (n > 0) {
+            inbuf.append(buf, (size_t)n);
+            got = 1;
+            continue;
+        }
+        int code = SSL_get_error(ssl, n);
+        if (code == SSL_ERROR_WANT_READ || code == SSL_ERROR_WANT_WRITE) return got;
+        if (got) return 1; // The error shows up again on the next call
+        if (code == SSL_ERROR_ZERO_RETURN || (code == SSL_ERROR_SYSCALL && errno == 0)) err = "Connection closed by server.";
+        else err = ssl_error_string();
+        return -1;
+    }
+}
+
+std::unique_ptr<HttpRequest> LinuxConnection::open(const std::string& method, const std::string& path,
+                                                   const std::string& referer) {
+    return std::make_unique<LinuxRequest>(transport, *this, method, path, referer);
+}
+
+// --- REQUEST ---
+
+LinuxRequest::LinuxRequest(LinuxTransport& transport, LinuxConnection& conn, const std::string& method,
+                           const std::string& path, const std::string& referer)
+    : transport(transport), conn(&conn), method(method), path(path), referer(referer) {
+    // A pooled socket starts every exchange at the default, set_timeout() narrows it for this one
+    conn.timeout_ms = IO_TIMEOUT_MS;
+}
+
+void LinuxRequest::set_timeout(int timeout_ms) {
+    conn->timeout_ms = timeout_ms > 0 ? timeout_ms : IO_TIMEOUT_MS;
+}
+
+LinuxRequest::~LinuxRequest() {
+    cancel_async();
+
+    if (rendered_for) {
+        // HTTP/2 cancels just this stream, the connection stays usable
+        bool cancelled = has_head && !body_done;
+        release_stream();
+        if (cancelled && conn->is_open()) conn->idle = true;
+    } else if (has_head && !body_done) {
+        // Leave the socket clean for the next request, or drop it if that is not possible
+        read_body(transport.discard_buffer());
+    } else if (sent && !has_head) {
+        conn->close();
+    }
+
+    if (hop && hop->is_open() && hop->idle) transport.park(std::move(hop));
+}
+
+bool LinuxRequest::fail(const std::string& what) {
+    err = what.empty() ? conn->error() : what + ": " + conn->error();
+    conn->close();
+    return false;
+}
+
+void LinuxRequest::release_stream() {
+    Http2Session* session = conn->h2 && conn->h2->id() == rendered_for ? conn->h2.get() : nullptr;
+    if (session) {
+        if (block_pending) session->block_dropped();
+        std::string out;
+        session->close(stream, out);
+        if (!out.empty()) conn->write_all(out.data(), out.size());
+    }
+    block_pending = false;
+    stream = Http2Stream();
+}
+
+// Lays out the complete request in one locked buffer so transmit() is a plain write. The
+// connection is opened first, the layout depends on the protocol ALPN settles on
+bool LinuxRequest::render() {
+    release_stream();
+    if (!conn->ensure_open()) return fail("Cannot open connection");
+    std::string cookie = transport.cookies().header_for(conn->host(), path);
+    if (conn->h2) return render_h2(cookie);
+    rendered_for = 0;
+
+    std::string head = method + " " + path + " HTTP/1.1\r\n";
+    head += "Host: " + conn->host() + (conn->get_port() == 443 ? "" : ":" + std::to_string(conn->get_port())) + "\r\n";
+    head += "User-Agent: " + transport.user_agent() + "\r\n";
+    head += "Connection: keep-alive\r\n";
+    if (req_headers.find("Accept:") == std::string::npos) head += "Accept: */*\r\n";
+    if (!referer.empty()) head += "Referer: " + referer + "\r\n";
+
+    if (!cookie.empty()) head += "Cookie: " + cookie + "\r\n";
+
+    head += req_headers;
+    if (!req_headers.empty() && req_headers.compare(req_headers.size() - 2, 2, "\r\n") != 0) head += "\r\n";
+    if (body_total > 0 || method == "POST" || method == "PUT") head += "Content-Length: " + std::to_string(body_total) + "\r\n";
+    head += "\r\n";
+
+    wire = std::make_unique<LockedBuffer>(head.size() + body_total);
+    if (!wire->append(head.data(), head.size()) || !wire->append(body, body_total)) {
+        err = "Could not allocate request buffer.";
+        return false;
+    }
+    head_len = head.size();
+    wire_sent = 0;
+    return true;
+}
+
+// Same request as HEADERS (+ CONTINUATION) and DATA frames. The stream id is filled in by transmit()
+bool LinuxRequest::render_h2(const std::string& cookie) {
+    std::string authority = conn->host() + (conn->get_port() == 443 ? "" : ":" + std::to_string(conn->get_port()));
+    HeaderList fields = {
+        {":method", method}, {":scheme", "https"}, {":authority", authority}, {":path", path},
+        {"user-agent", transport.user_agent()}
+    };
+    if (req_headers.find("Accept:") == std::string::npos) fields.emplace_back("accept", "*/*");
+    if (!referer.empty()) fields.emplace_back("referer", referer);
+    if (!cookie.empty()) fields.emplace_back("cookie", cookie);
+
+    for (size_t pos = 0; pos < req_headers.size(); ) {
+        size_t eol = req_headers.find("\r\n", pos);
+        if (eol == std::string::npos) eol = req_headers.size();
+        std::string line = req_headers.substr(pos, eol - pos);
+        pos = eol + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = lower_case(line.substr(0, colon));
+        // Connection-specific headers are not allowed in HTTP/2
+        if (name == "connection" || name == "host" || name == "keep-alive" || name == "transfer-encoding" ||
+            name == "upgrade" || name == "proxy-connection") continue;
+        size_t v = line.find_first_not_of(" \t", colon + 1);
+        fields.emplace_back(name, v == std::string::npos ? "" : line.substr(v));
+    }
+    if (body_total > 0 || method == "POST" || method == "PUT") fields.emplace_back("content-length", std::to_string(body_total));
+
+    std::string frames;
+    block_pending = conn->h2->render_headers(fields, body_total == 0, frames);
+    rendered_for = conn->h2->id();
+
+    size_t chunk = Http2Session::max_frame();
+    size_t count = (body_total + chunk - 1) / chunk;
+    wire = std::make_unique<LockedBuffer>(frames.size() + body_total + 9 * count);
+    bool ok = wire->append(frames.data(), frames.size());
+    for (size_t off = 0; ok && off < body_total; off += chunk) {
+        size_t n = std::min(chunk, body_total - off);
+        char head[9];
+        Http2Session::frame_header(head, (uint32_t)n, 0x0 /* DATA */, off + n == body_total ? 0x1 /* END_STREAM */ : 0, 0);
+        ok = wire->append(head, 9) && wire->append(body + off, n);
+    }
+    if (!ok) {
+        err = "Could not allocate request buffer.";
+        return false;
+    }
+    head_len = frames.size();
+    wire_sent = 0;
+    body_sent = 0;
+    return true;
+}
+
+// Wire offset that holds the body up to upto, counting the DATA frame headers in front of it
+size_t LinuxRequest::wire_offset(size_t upto) const {
+    if (!rendered_for) return head_len + upto;
+    size_t chunk = Http2Session::max_frame();
+    return head_len + upto + 9 * ((upto + chunk - 1) / chunk);
+}
+
+bool LinuxRequest::stage(std::string_view headers, const char* body, size_t total_len) {
+    req_headers = std::string(headers);
+    this->body = body;
+    body_total = total_len;
+    return render();
+}
+
+bool LinuxRequest::is_stale() const {
+    if (!wire || wire_sent > 0) return false;
+    // Reopening the socket starts a new HTTP/2 session
+    if (!conn->is_open()) return rendered_for != 0;
+    return (conn->h2 ? conn->h2->id() : 0) != rendered_for;
+}
+
+bool LinuxRequest::transmit(size_t upto) {
+    if (!wire || upto > body_total || wire_offset(upto) < wire_sent) {
+        err = "transmit() called without a staged request";
+        return false;
+    }
+
+    if (wire_sent == 0) {
+        if (!conn->ensure_open()) return fail("Cannot open connection");
+
+        // Frames rendered for another session are useless here, and rendering them again
+        // allocates. The caller re-stages ahead of the critical window instead
+        if (is_stale()) {
+            err = "Connection moved to a new HTTP/2 session since the request was staged, stage it again.";
+            return false;
+        }
+
+        if (rendered_for) {
+            if (!conn->h2->can_open()) {
+                err = "HTTP/2 session does not accept new streams.";
+                return false;
+            }
+            conn->h2->open(stream, wire->data(), wire->size());
+            if (block_pending) conn->h2->block_sent();
+            block_pending = false;
+        }
+        conn->idle = false;
+        sent = true;
+        has_head = false;
+    } else if (!conn->is_open()) {
+        err = "Connection dropped while streaming the request.";
+        return false;
+    }
+
+    do {
+        size_t next = upto;
+        if (rendered_for) {
+            // HTTP/2 flow control: as many whole DATA frames as the server's window takes, the
+            // rest after its WINDOW_UPDATEs. A body that fits goes out in a single write
+            if (!conn->h2) return fail("Send failed");
+            int64_t window = conn->h2->send_window(stream);
+            if (window < (int64_t)(upto - body_sent)) {
+                size_t chunk = Http2Session::max_frame();
+                next = window > 0 ? (body_sent + (size_t)window) / chunk * chunk : 0;
+                if (next <= body_sent) {
+                    if (stream.reset || !conn->read_some()) return fail("Flow control wait failed");
+                    continue;
+                }
+            }
+            conn->h2->consume_window(stream, next - body_sent);
+        }
+
+        size_t end = wire_offset(next);
+        if (!conn->write_all(wire->data() + wire_sent, end - wire_sent)) return fail("Send failed");
+        wire_sent = end;
+        body_sent = next;
+    } while (body_sent < upto);
+    return true;
+}
+
+bool LinuxRequest::read_head() {
+    if (rendered_for) {
+        while (!stream.has_head) {
+            if (stream.reset) {
+                err = "Stream reset by server (error " + std::to_string(stream.error) + ").";
+                return false;
+            }
+            if (!conn->read_some()) return fail("Receive failed");
+        }
+        status = stream.status;
+        headers.swap(stream.headers);
+        close_after = false;
+        has_head = true;
+        return true;
+    }
+
+    size_t end;
+    while ((end = conn->inbuf.find("\r\n\r\n")) == std::string::npos) {
+        if (!conn->read_some()) return fail("Receive failed");
+    }
+
+    std::string head = conn->inbuf.substr(0, end + 2);
+    conn->inbuf.erase(0, end + 4);
+
+    // Status line: HTTP/1.1 200 OK
+    size_t line_end = head.find("\r\n");
+    size_t sp = head.find(' ');
+    if (sp == std::string::npos || sp > line_end) {
+        err = "Malformed status line.";
+        conn->close();
+        return false;
+    }
+    status = std::atoi(head.c_str() + sp + 1);
+    close_after = head.compare(0, 8, "HTTP/1.0") == 0;
+
+    headers.clear();
+    size_t pos = line_end + 2;
+    while (pos < head.size()) {
+        size_t eol = head.find("\r\n", pos);
+        std::string line = head.substr(pos, eol - pos);
+        pos = eol + 2;
+
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string name = lower_case(line.substr(0, colon));
+        size_t v = line.find_first_not_of(" \t", colon + 1);
+        headers.emplace_back(name, v == std::string::npos ? "" : line.substr(v));
+    }
+    has_head = true;
+    return true;
+}
+
+bool LinuxRequest::receive() {
+    cancel_async();
+    for (int redirects = 0; ; ) {
+        do {
+            if (!read_head()) return false;
+        } while (status >= 100 && status < 200);
+
+        Step step = on_head(redirects);
+        if (step != Step::Redirected) return step == Step::Done;
+    }
+}
+
+void LinuxRequest::receive_async(std::function<void(bool ok)> done) {
+    cancel_async();
+    on_done = std::move(done);
+    async_redirects = 0;
+    if (!sent) {
+        err = "receive_async() called before the request was sent";
+        complete_async(false);
+        return;
+    }
+    conn->add_reader(this);
+}
+
+bool LinuxRequest::on_readable(LinuxConnection& from) {
+    if (!on_done) return true;
+
+    bool ok = true;
+    while (true) {
+        if (!head_ready()) {
+            if (!conn->is_open()) {
+                err = conn->error().empty() ? "Connection closed." : conn->error();
+                ok = false;
+                break;
+            }
+            if (conn == &from) return false;
+            // A redirect moved the request to another connection, wait there
+            conn->add_reader(this);
+            return true;
+        }
+        if (!read_head()) {
+            ok = false;
+            break;
+        }
+        if (status >= 100 && status < 200) continue;
+
+        Step step = on_head(async_redirects);
+        if (step == Step::Redirected) continue; // Next hop is on the wire, wait for its head
+        ok = step == Step::Done;
+        break;
+    }
+    complete_async(ok);
+    return true;
+}
+
+void LinuxRequest::complete_async(bool ok) {
+    std::function<void(bool)> done = std::move(on_done);
+    on_done = nullptr;
+    if (done) done(ok);
+}
+
+void LinuxRequest::cancel_async() {
+    if (!on_done) return;
+    on_done = nullptr;
+    conn->remove_reader(this);
+}
+
+LinuxRequest::Step LinuxRequest::on_head(int& redirects) {
+    for (const auto& h : headers) {
+        if (h.first == "set-cookie") transport.cookies().store(conn->host(), path, h.second);
+    }
+
+    std::string connection = lower_case(query_header("connection"));
+    if (connection.find("close") != std::string::npos) close_after = true;
+    if (connection.find("keep-alive") != std::string::npos) close_after = false;
+
+    std::string te = lower_case(query_header("transfer-encoding"));
+    std::string cl = query_header("content-length");
+    body_done = false;
+    if (method == "HEAD" || status == 204 || status == 304) {
+        framing = Framing::None;
+    } else if (rendered_for) {
+        framing = Framing::Stream;
+    } else if (te.find("chunked") != std::string::npos) {
+        framing = Framing::Chunked;
+        content_left = 0;
+        in_chunk = false;
+    } else if (!cl.empty()) {
+        framing = Framing::Length;
+        content_left = (size_t)std::strtoull(cl.c_str(), nullptr, 10);
+    } else {
+        framing = Framing::Close;
+    }
+    if (framing == Framing::None || (framing == Framing::Length && content_left == 0)) finish();
+
+    std::string location = query_header("location");
+    bool redirect = status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+    // 307/308 would need the original body replayed, hand those back to the caller instead
+    if (!redirect || location.empty() || redirects++ >= MAX_REDIRECTS ||
+        ((status == 307 || status == 308) && body_total > 0)) {
+        return Step::Done;
+    }
+
+    read_body(transport.discard_buffer());
+    release_stream(); // Before conn may change below, the stream belongs to this connection's session
+
+    std::string new_host = conn->host();
+    if (location.compare(0, 8, "https://") == 0) {
+        size_t slash = location.find('/', 8);
+        new_host = location.substr(8, slash == std::string::npos ? std::string::npos : slash - 8);
+        path = slash == std::string::npos ? "/" : location.substr(slash);
+    } else if (location.compare(0, 7, "http://") == 0) {
+        // Never downgrade to plain HTTP, same policy as WinHTTP
+        return Step::Done;
+    } else if (location[0] == '/') {
+        path = location;
+    } else {
+        size_t dir = path.rfind('/', path.find('?'));
+        path = path.substr(0, dir + 1) + location;
+    }
+
+    if (status == 303 || ((status == 301 || status == 302) && method == "POST")) {
+        method = "GET";
+        req_headers.clear();
+        body = nullptr;
+        body_total = 0;
+    }
+
+    if (lower_case(new_host) != lower_case(conn->host())) {
+        hop = std::make_unique<LinuxConnection>(transport, new_host, 443);
+        hop->timeout_ms = conn->timeout_ms;
+        conn = hop.get();
+    }
+    if (!render() || !transmit(body_total)) return Step::Failed;
+    return Step::Redirected;
+}
+
+std::string LinuxRequest::query_header(const std::string& name) {
+    std::string key = lower_case(name);
+    for (const auto& h : headers) {
+        if (h.first == key) return h.second;
+    }
+    return "";
+}
+
+// True if done wants no more of the body
+static bool enough(const HttpRequest::BodyCheck& done, const ResponseBuffer& out) {
+    return done && done(out.view());
+}
+
+LinuxRequest::Read LinuxRequest::read_chunked(ResponseBuffer& out, const BodyCheck& done) {
+    while (true) {
+        size_t eol;
+        if (!in_chunk) {
+            while ((eol = conn->inbuf.find("\r\n")) == std::string::npos) {
+                if (!conn->read_some()) return Read::Failed;
+            }
+            size_t size = (size_t)std::strtoull(conn->inbuf.c_str(), nullptr, 16);
+            conn->inbuf.erase(0, eol + 2);
+
+            if (size == 0) {
+                // Skip trailers up to the terminating empty line
+                while (true) {
+                    while ((eol = conn->inbuf.find("\r\n")) == std::string::npos) {
+                        if (!conn->read_some()) return Read::Failed;
+                    }
+                    conn->inbuf.erase(0, eol + 2);
+                    if (eol == 0) return Read::Complete;
+                }
+            }
+            content_left = size;
+            in_chunk = true;
+        }
+
+        // Chunk data is passed on as it arrives, a stopped read resumes inside the chunk
+        while (content_left > 0) {
+            if (conn->inbuf.empty() && !conn->read_some()) return Read::Failed;
+            size_t n = std::min(content_left, conn->inbuf.size());
+            if (!out.append(conn->inbuf.data(), n)) return Read::Failed;
+            conn->inbuf.erase(0, n);
+            content_left -= n;
+            if (content_left > 0 && enough(done, out)) return Read::Stopped;
+        }
+        while (conn->inbuf.size() < 2) {
+            if (!conn->read_some()) return Read::Failed;
+        }
+        conn->inbuf.erase(0, 2);
+        in_chunk = false;
+        if (enough(done, out)) return Read::Stopped;
+    }
+}
+
+// Whatever inbuf already holds is moved over, the rest is read from TLS straight into out.
+// content_left follows along, so a stopped read can be drained later
+LinuxRequest::Read LinuxRequest::read_length(ResponseBuffer& out, const BodyCheck& done) {
+    size_t have = std::min(content_left, conn->inbuf.size());
+    if (!out.append(conn->inbuf.data(), have)) return Read::Failed;
+    conn->inbuf.erase(0, have);
+    content_left -= have;
+    if (content_left > 0 && have > 0 && enough(done, out)) return Read::Stopped;
+
+    while (content_left > 0) {
+        size_t step = done ? std::min(content_left, STREAM_STEP) : content_left;
+        char* dst = out.prepare(step);
+        size_t got = dst ? conn->read_into(dst, step) : 0;
+        if (got == 0) return Read::Failed;
+        out.commit(got);
+        content_left -= got;
+        if (content_left > 0 && enough(done, out)) return Read::Stopped;
+    }
+    return Read::Complete;
+}
+
+LinuxRequest::Read LinuxRequest::read_to_close(ResponseBuffer& out, const BodyCheck& done) {
+    close_after = true;
+    out.append(conn->inbuf.data(), conn->inbuf.size());
+    conn->inbuf.clear();
+    while (char* dst = out.prepare(16384)) {
+        size_t got = conn->read_into(dst, 16384);
+        if (got == 0) break;
+        out.commit(got);
+        if (enough(done, out)) return Read::Stopped;
+    }
+    return Read::Complete;
+}
+
+// DATA frames are interleaved with other streams, the session collects them per stream
+LinuxRequest::Read LinuxRequest::read_stream(ResponseBuffer& out, const BodyCheck& done) {
+    while (true) {
+        if (!stream.data.empty()) {
+            out.append(stream.data.data(), stream.data.size());
+            stream.data.clear();
+            if (!stream.ended && enough(done, out)) return Read::Stopped;
+        }
+        if (stream.ended) return Read::Complete;
+        if (stream.reset || !conn->read_some()) {
+            if (stream.reset) err = "Stream reset by server (error " + std::to_string(stream.error) + ").";
+            else fail("Receive failed");
+            body_done = true;
+            return Read::Failed;
+        }
+    }
+}
+
+std::string_view LinuxRequest::read_body(ResponseBuffer& out) {
+    return read_body_until(out, BodyCheck());
+}
+
+std::string_view LinuxRequest::read_body_until(ResponseBuffer& out, const BodyCheck& done) {
+    out.clear();
+    if (!has_head || body_done) return out.view();
+
+    Read result = Read::Complete;
+    switch (framing) {
+        case Framing::Length:  result = read_length(out, done); break;
+        case Framing::Chunked: result = read_chunked(out, done); break;
+        case Framing::Close:   result = read_to_close(out, done); break;
+        case Framing::Stream:  result = read_stream(out, done); break;
+        case Framing::None:    break;
+    }
+
+    // A stopped body stays pending: the destructor drains it, or cancels the HTTP/2 stream
+    if (result == Read::Failed && framing != Framing::Stream) fail("Receive failed"); // Streams record their own
+    else if (result == Read::Complete) finish();
+    if (result == Read::Complete && done) done(out.view());
+    return out.view();
+}
+
+void LinuxRequest::finish() {
+    body_done = true;
+    if (close_after) conn->close();
+    else conn->idle = true;
+}
+
+std::string LinuxRequest::url() {
+    std::string port = conn->get_port() == 443 ? "" : ":" + std::to_string(conn->get_port());
+    return "https://" + conn->host() + port + path;
+}
+
+// --- TRANSPORT ---
+
+LinuxTransport::LinuxTransport(const std::string& user_agent, const TransportOptions& options)
+    : events(EventLoop::create(options.event_loop)), agent(user_agent), http2(options.http2), low_priority(options.low_priority) {
+    // A server reset mid-write must surface as an error, not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+
+    if (events) std::cout << "[Net] Event loop: " << events->name() << std::endl;
+    else std::cerr << "[Net] Event loop \"" << options.event_loop << "\" is not available." << std::endl;
+
+    ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_default_verify_paths(ctx);
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_PEER, nullptr);
+    if (!options.extra_ca_pem.empty()) {
+        BIO* bio = BIO_new_mem_buf(options.extra_ca_pem.data(), (int)options.extra_ca_pem.size());
+        X509* cert = bio ? PEM_read_bio_X509(bio, nullptr, nullptr, nullptr) : nullptr;
+        if (!cert || X509_STORE_add_cert(SSL_CTX_get_cert_store(ctx), cert) != 1) std::cerr << "[TLS] Extra CA certificate could not be loaded." << std::endl;
+        X509_free(cert);
+        BIO_free(bio);
+    }
+
+    // Offer h2 first, servers without it answer with (or ignore ALPN and speak) HTTP/1.1
+    static const unsigned char alpn_h2[] = "\x02h2\x08http/1.1";
+    static const unsigned char alpn_h1[] = "\x08http/1.1";
+    if (http2) SSL_CTX_set_alpn_protos(ctx, alpn_h2, sizeof(alpn_h2) - 1);
+    else SSL_CTX_set_alpn_protos(ctx, alpn_h1, sizeof(alpn_h1) - 1);
+
+    // Keep session tickets ourselves (keyed by host:port) so a dropped connection resumes
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(ctx, &LinuxTransport::on_new_session);
+    SSL_CTX_set_app_data(ctx, this);
+}
+
+LinuxTransport::~LinuxTransport() {
+    spare.clear();
+    for (auto& [key, session] : sessions) SSL_SESSION_free(session);
+    if (ctx) SSL_CTX_free(ctx);
+}
+
+int LinuxTransport::on_new_session(SSL* ssl, SSL_SESSION* session) {
+    auto* transport = (LinuxTransport*)SSL_CTX_get_app_data(SSL_get_SSL_CTX(ssl));
+    auto* conn = (LinuxConnection*)SSL_get_app_data(ssl);
+    if (!transport || !conn) return 0;
+
+    std::string key = conn->session_key();
+    auto it = transport->sessions.find(key);
+    if (it != transport->sessions.end()) SSL_SESSION_free(it->second);
+    transport->sessions[key] = session;
+    transport->tls_stats[key].early_data = SSL_SESSION_get_max_early_data(session) > 0;
+    return 1; // We own the reference now
+}
+
+SSL_SESSION* LinuxTransport::session_for(const std::string& key) {
+    auto it = sessions.find(key);
+    if (it == sessions.end()) return nullptr;
+    if (!SSL_SESSION_is_resumable(it->second)) return nullptr;
+    return it->second;
+}
+
+void LinuxTransport::record_handshake(const std::string& key, double ms, bool resumed, const char* protocol) {
+    TlsStats& st = tls_stats[key];
+    st.protocol = protocol;
+    st.handshakes++;
+    if (resumed) st.resumed++;
+    st.last_ms = ms;
+    st.total_ms += ms;
+    if (st.handshakes == 1 || ms < st.best_ms) st.best_ms = ms;
+    if (ms > st.worst_ms) st.worst_ms = ms;
+
+    // The first connection to a host is always a full handshake, reconnects are the interesting ones
+    if (st.handshakes > 1) {
+        std::cout << "[TLS] Reconnected to " << key << " in " << (long long)ms << "ms ("
+                  << (resumed ? "resumed" : "full handshake") << ")" << std::endl;
+    }
+}
+
+void LinuxTransport::fill_report(RunReport& report) const {
+    if (events) report.section("network")["event_loop"] = events->name();
+
+    auto& tls = report.section("tls");
+    for (const auto& [key, st] : tls_stats) {
+        tls[key] = {
+            {"handshakes", st.handshakes},
+            {"resumed", st.resumed},
+            {"last_ms", st.last_ms},
+            {"best_ms", st.best_ms},
+            {"worst_ms", st.worst_ms},
+            {"avg_ms", st.handshakes ? st.total_ms / st.handshakes : 0.0},
+            {"ticket_allows_0rtt", st.early_data},
+            {"protocol", st.protocol}
+        };
+    }
+}
+
+int LinuxTransport::poll(int timeout_ms) {
+    return events ? events->run_once(timeout_ms) : HttpTransport::poll(timeout_ms);
+}
+
+std::unique_ptr<HttpConnection> LinuxTransport::connect(const std::string& host, int port) {
+    if (!ctx || !events) return nullptr;
+
+    auto it = spare.find(lower_case(host) + ":" + std::to_string(port));
+    if (it != spare.end() && !it->second.empty()) {
+        std::unique_ptr<LinuxConnection> conn = std::move(it->second.back());
+        it->second.pop_back();
+        return conn;
+    }
+    return std::make_unique<LinuxConnection>(*this, host, port);
+}
+
+std::vector<ResolvedAddress> LinuxTransport::addresses(const std::string& host, int port) {
+    if (dns) return dns->lookup(host, port);
+    double ms = 0;
+    return system_resolve(host, port, ms);
+}
+
+void LinuxTransport::park(std::unique_ptr<LinuxConnection> conn) {
+    std::string key = lower_case(conn->host()) + ":" + std::to_string(conn->get_port());
+    spare[key].push_back(std::move(conn));
+}
+
+#endif
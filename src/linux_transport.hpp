@@ -0,0 +1,241 @@
+#pragma once
+#ifdef __linux__
+#include <openssl/ssl.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <map>
+#include <functional>
+#include "transport.hpp"
+#include "event_loop.hpp"
+#include "http2.hpp"
+#include "cookies.hpp"
+#include "memory.hpp"
+#include "resolver.hpp"
+
+// Native Linux backend: non-blocking sockets on one shared event loop (io_uring or epoll),
+// TLS through OpenSSL, HTTP/2 when the server offers it through ALPN and HTTP/1.1 with
+// keep-alive otherwise. Cookies and redirects are handled here since there is no WinHTTP
+// doing it for us.
+
+class LinuxTransport;
+class LinuxRequest;
+
+class LinuxConnection : public HttpConnection {
+private:
+    LinuxTransport& transport;
+    std::string host_name;
+    int port;
+    int fd = -1;
+    SSL* ssl = nullptr;
+    std::string err;
+    bool wait_timed_out = false;
+
+    // Requests waiting for their response without blocking, and an unanswered PING
+    std::vector<LinuxRequest*> readers;
+    std::function<void(bool)> on_pong;
+    uint64_t pongs_seen = 0;
+    bool dispatching = false;
+    bool redispatch = false;
+
+    // Waits for readiness on the socket, false on timeout
+    bool wait(uint32_t events, int timeout_ms);
+    // Resolves SSL_ERROR_WANT_* by waiting on the socket, false on a real error
+    bool wait_ssl(int ret);
+    bool is_stale();
+    // Feeds inbuf to the HTTP/2 session and writes its replies
+    bool process_h2();
+    // Reads what is available and lets waiting requests look at it
+    void pump();
+    void dispatch_readers();
+    void watch_readers();
+
+public:
+    std::string inbuf;   // Received bytes not consumed by a response (or the HTTP/2 session) yet
+    bool idle = false;   // A previous exchange completed, socket kept alive
+    int timeout_ms;      // Limit of each blocking wait, set by the request using the socket
+    std::unique_ptr<Http2Session> h2; // Set when ALPN picked h2, requests become streams
+
+    // host:port, the key for TLS tickets and statistics
+    std::string session_key() const { return host_name + ":" + std::to_string(port); }
+
+    LinuxConnection(LinuxTransport& transport, const std::string& host, int port);
+    ~LinuxConnection();
+
+    // Opens (or re-opens a dropped) TCP + TLS session
+    bool ensure_open();
+    void close();
+    bool is_open() const { return ssl != nullptr; }
+
+    bool write_all(const char* data, size_t len);
+    // Appends at least one byte to inbuf, false on EOF or error. With HTTP/2 the bytes go
+    // straight into the session and end up in the streams
+    bool read_some();
+    // Reads at least one byte of the TLS stream into dst (HTTP/1.1 bodies, bypassing inbuf),
+    // 0 on EOF or error
+    size_t read_into(char* dst, size_t cap);
+    // Appends whatever is readable without blocking: 1 if bytes came in, 0 if nothing
+    // is ready yet, -1 on EOF or error
+    int read_available();
+    int socket() const { return fd; }
+    // The last blocking wait gave up
+    bool timed_out() const { return wait_timed_out; }
+
+    // Registers a request to be called back from the event loop as response bytes arrive
+    void add_reader(LinuxRequest* request);
+    void remove_reader(LinuxRequest* request);
+
+    const std::string& error() const { return err; }
+    int get_port() const { return port; }
+
+    std::unique_ptr<HttpRequest> open(const std::string& method, const std::string& path,
+                                      const std::string& referer = "") override;
+    bool preconnect() override { return ensure_open(); }
+    bool ping_async(std::function<void(bool ok)> done) override;
+    const std::string& host() const override { return host_name; }
+};
+
+class LinuxRequest : public HttpRequest {
+private:
+    enum class Framing { None, Length, Chunked, Close, Stream };
+
+    LinuxTransport& transport;
+    LinuxConnection* conn;
+    std::unique_ptr<LinuxConnection> hop; // Connection to another host after a redirect
+    std::string method, path, referer;
+    std::string req_headers;
+    const char* body = nullptr;
+    size_t body_total = 0;
+    std::unique_ptr<LockedBuffer> wire; // Exact request bytes: head followed by body
+    size_t head_len = 0;
+    size_t wire_sent = 0;
+
+    // HTTP/2: the stream this request runs on and the session its frames were rendered for
+    Http2Stream stream;
+    uint64_t rendered_for = 0;  // Session id, 0 for HTTP/1.1
+    bool block_pending = false; // Rendered header block uses the dynamic table and is not sent yet
+    size_t body_sent = 0;
+
+    bool sent = false;
+    bool has_head = false;
+    bool body_done = true;
+    bool close_after = false;
+    int status = 0;
+    std::vector<std::pair<std::string, std::string>> headers; // Lower-case names
+    Framing framing = Framing::None;
+    size_t content_left = 0; // Body bytes left, or bytes left in the current chunk
+    bool in_chunk = false;
+    std::string err;
+
+    // Asynchronous receive in flight
+    std::function<void(bool)> on_done;
+    int async_redirects = 0;
+
+    enum class Step { Done, Redirected, Failed };
+
+    bool render();
+    bool render_h2(const std::string& cookie);
+    void release_stream();
+    size_t wire_offset(size_t upto) const;
+    bool read_head();
+    bool head_ready() const {
+        return rendered_for ? stream.has_head || stream.reset : conn->inbuf.find("\r\n\r\n") != std::string::npos;
+    }
+    // Processes a freshly read head: cookies, framing, and following a redirect if there is one
+    Step on_head(int& redirects);
+    // Called by the connection as bytes arrive. True once the request stops waiting on from
+    bool on_readable(LinuxConnection& from);
+    void complete_async(bool ok);
+    void cancel_async();
+
+    friend class LinuxConnection;
+    enum class Read { Complete, Stopped, Failed };
+    // Body readers for each framing, done (may be empty) is asked after every piece
+    Read read_chunked(ResponseBuffer& out, const BodyCheck& done);
+    Read read_length(ResponseBuffer& out, const BodyCheck& done);
+    Read read_to_close(ResponseBuffer& out, const BodyCheck& done);
+    Read read_stream(ResponseBuffer& out, const BodyCheck& done);
+    void finish();
+    bool fail(const std::string& what);
+
+public:
+    LinuxRequest(LinuxTransport& transport, LinuxConnection& conn, const std::string& method,
+                 const std::string& path, const std::string& referer);
+    ~LinuxRequest();
+
+    bool stage(std::string_view headers, const char* body, size_t total_len) override;
+    bool transmit(size_t upto) override;
+    bool is_stale() const override;
+    bool receive() override;
+    void receive_async(std::function<void(bool ok)> done) override;
+    int status_code() override { return status; }
+    std::string query_header(const std::string& name) override;
+    std::string_view read_body(ResponseBuffer& out) override;
+    std::string_view read_body_until(ResponseBuffer& out, const BodyCheck& done) override;
+    std::string url() override;
+    std::string last_error() const override { return err; }
+    void set_timeout(int timeout_ms) override;
+    bool timed_out() const override { return conn->timed_out(); }
+};
+
+class LinuxTransport : public HttpTransport {
+private:
+    std::unique_ptr<EventLoop> events; // Destroyed last, after every socket is gone
+    SSL_CTX* ctx;
+    std::string agent;
+    bool http2;
+    bool low_priority;
+    CookieJar jar;
+    ResponseBuffer discard{16 * 1024}; // Bodies nobody asked for (redirects, unread responses)
+    std::map<std::string, std::vector<std::unique_ptr<LinuxConnection>>> spare; // Live sockets left over from redirects
+    Resolver* dns = nullptr;
+
+    // Handshake measurements per host:port, reported at the end of the run
+    struct TlsStats {
+        int handshakes = 0;
+        int resumed = 0;
+        double last_ms = 0;
+        double best_ms = 0;
+        double worst_ms = 0;
+        double total_ms = 0;
+        bool early_data = false; // Cached ticket would allow 0-RTT
+        std::string protocol;    // ALPN result of the last handshake
+    };
+    std::map<std::string, SSL_SESSION*> sessions; // Latest TLS session ticket per host:port
+    std::map<std::string, TlsStats> tls_stats;
+
+    static int on_new_session(SSL* ssl, SSL_SESSION* session);
+
+public:
+    LinuxTransport(const std::string& user_agent, const TransportOptions& options = {});
+    ~LinuxTransport();
+
+    std::unique_ptr<HttpConnection> connect(const std::string& host, int port = 443) override;
+    const char* name() const override { return "linux"; }
+    void set_resolver(Resolver* resolver) override { dns = resolver; }
+    void fill_report(RunReport& report) const override;
+    int poll(int timeout_ms) override;
+
+    // Ticket to offer when (re)connecting, nullptr if none was issued yet
+    SSL_SESSION* session_for(const std::string& key);
+    void record_handshake(const std::string& key, double ms, bool resumed, const char* protocol);
+
+    // Keeps a live socket opened by a redirect so the next connect() to that host reuses it,
+    // the way WinHTTP shares sockets across connection handles of one session
+    void park(std::unique_ptr<LinuxConnection> conn);
+
+    // Addresses to connect to: the pinned ones if a resolver is set, a fresh lookup otherwise
+    std::vector<ResolvedAddress> addresses(const std::string& host, int port);
+
+    EventLoop& loop() { return *events; }
+    SSL_CTX* context() { return ctx; }
+    bool http2_enabled() const { return http2; }
+    bool is_low_priority() const { return low_priority; }
+    CookieJar& cookies() { return jar; }
+    CookieJar* cookie_jar() override { return &jar; }
+    ResponseBuffer& discard_buffer() { return discard; }
+    const std::string& user_agent() const { return agent; }
+};
+
+#endif
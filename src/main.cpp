@@ -1,43 +1,71 @@
+#ifdef _WIN32
+#include <winsock2.h>
 #include <windows.h>
-#include <winhttp.h>
+#endif
 #include <iostream>
 #include <fstream>
+#include <iomanip>
+#include <memory>
 #include <string>
 #include <chrono>
+#include <ctime>
 #include <thread>
 #include <vector>
 #include "clock.hpp"
 #include "token.hpp"
+#include "token_cache.hpp"
 #include "response.hpp"
+#include "transport.hpp"
+#include "arm.hpp"
+#include "fire.hpp"
+#include "memory.hpp"
+#include "pool.hpp"
+#include "resolver.hpp"
+#include "report.hpp"
+#include "timezone.hpp"
+#include "realtime.hpp"
+#include "bench.hpp"
 #include "../include/nlohmann_json.hpp"
 
-#pragma comment(lib, "winhttp.lib")
-
 using json = nlohmann::json;
 
 struct ConfigFlags {
     bool debug;
     bool test;
     bool local;
+    bool bench;
 };
 
 int main(int argc, char *argv[]) {
+#ifdef _WIN32
     SetConsoleOutputCP(65001); // Allow unicode characters on console
+#endif
 
     // Configure program flags
     const ConfigFlags flags = [argc, argv](){
-        bool d = false, t = false, l = false;
+        bool d = false, t = false, l = false, b = false;
 
         for(int i = 1; i < argc; i++){
             std::string arg = argv[i];
             if(arg == "-logs") d = true;
             if(arg == "-test") t = true;
             if(arg == "-local") l = false;
+            if(arg == "-bench") b = true;
         }
 
-        return ConfigFlags{d, t, l};
+        return ConfigFlags{d, t, l, b};
     }();
 
+    if(flags.bench){
+        run_reader_bench();
+        run_form_bench();
+        run_urlform_bench();
+        run_wake_bench();
+        run_date_bench();
+        run_tls_bench();
+        return 0;
+    }
+
     // Load Configuration
     std::ifstream config_file("data/config.json");
     if (!config_file.is_open()) {
@@ -47,80 +75,150 @@ int main(int argc, char *argv[]) {
     json config;
     config_file >> config;
 
-    // Initialize Helpers
-    SystemClock itu_clock;
-    TokenFetcher itu_auth;
-
-    // Setup Persistent Session with Chrome User-Agent
-    HINTERNET hSession = WinHttpOpen(L"Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/144.0.0.0 Safari/537.36", 
-                                    WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, 
-                                    WINHTTP_NO_PROXY_NAME, 
-                                    WINHTTP_NO_PROXY_BYPASS, 0);
+    // Pick the network backend for this host ("auto", "winhttp" or "linux") and, on Linux,
+    // the readiness loop under it ("auto", "io_uring" or "epoll")
+    json net_cfg = config.value("network", json::object());
+    std::string backend = net_cfg.value("transport", "auto");
+    TransportOptions net_opts;
+    net_opts.event_loop = net_cfg.value("event_loop", "auto");
+    net_opts.http2 = net_cfg.value("http2", true);
 
-    DWORD protocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
-    WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS, &protocols, sizeof(protocols));
+    RunReport report;
 
-    HINTERNET hConnect = WinHttpConnect(hSession, L"obs.itu.edu.tr", INTERNET_DEFAULT_HTTPS_PORT, 0);
+    // Resolve every host we will talk to up front and keep the answers pinned
+    Resolver dns;
+    for (const char* host : {"obs.itu.edu.tr", "girisv3.itu.edu.tr"}) {
+        if (!dns.resolve(host)) std::cout << "[Warning] Could not resolve " << host << std::endl;
+    }
+    dns.start_refresh(net_cfg.value("dns_refresh_s", 10) * 1000);
 
-    if (!hConnect) {
-        std::cerr << "[Fatal] Could not connect to servers. Error: " << GetLastError() << std::endl;
+    // Setup Persistent Session with Chrome User-Agent, shared by every phase through the pool
+    const std::string user_agent = "Mozilla/5.0 (Windows NT 10.0; Win64; x64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/144.0.0.0 Safari/537.36";
+    auto transport = make_transport(backend, user_agent, net_opts);
+    if (!transport) {
+        std::cerr << "[Fatal] Transport \"" << backend << "\" is not available on this platform." << std::endl;
         return 1;
     }
+    std::cout << "[System] Using " << transport->name() << " transport." << std::endl;
+    transport->set_resolver(&dns);
 
-    // Initial Clock Sync
-    if(!flags.local){
-        itu_clock.sync_with_server(hConnect);
-    }else{
-        std::cout << "[Clock] Skipping server synchronization." << std::endl;
+    ConnectionPool pool(*transport);
+
+    // Initialize Helpers
+    SystemClock itu_clock;
+    json clock_cfg = config.value("clock", json::object());
+    itu_clock.set_edge_probes(clock_cfg.value("edge_probes", 8));
+    itu_clock.set_probe_plan(clock_cfg.value("probe_count", 4), clock_cfg.value("probe_interval_ms", 100));
+    {
+        // Sync probes run on a low priority transport and connections of their own, never on the
+        // pooled connection the login and the registration request use
+        TransportOptions probe_opts = net_opts;
+        probe_opts.low_priority = true;
+        auto probe_lane = make_transport(backend, user_agent, probe_opts);
+        if (probe_lane) probe_lane->set_resolver(&dns);
+        itu_clock.set_probe_lane(std::move(probe_lane), "obs.itu.edu.tr", clock_cfg.value("burst", 4));
+    }
+    itu_clock.wake_engine().set_spin_cpu(clock_cfg.value("spin_cpu", -1));
+    itu_clock.wake_engine().calibrate();
+    itu_clock.wake_engine().print_summary();
+
+    {
+        auto connection = pool.acquire("obs.itu.edu.tr");
+
+        if (!connection) {
+            std::cerr << "[Fatal] Could not connect to servers." << std::endl;
+            return 1;
+        }
+
+        // Initial Clock Sync
+        if(!flags.local){
+            if(itu_clock.has_probe_lane()) itu_clock.sync_with_server();
+            else itu_clock.sync_with_server(*connection);
+        }else{
+            std::cout << "[Clock] Skipping server synchronization." << std::endl;
+        }
     }
     
-    // Calculate Target Time Points
+    // Calculate Target Time Points: the config time is a wall clock time in time.zone (the
+    // registration system's zone), never in the zone of the machine running the bot
     auto t = config["time"];
-    std::tm target_tm = {};
-    target_tm.tm_year = t["year"].get<int>() - 1900;
-    target_tm.tm_mon  = t["month"].get<int>() - 1;
-    target_tm.tm_mday = t["day"].get<int>();
-    target_tm.tm_hour = t["hour"].get<int>();
-    target_tm.tm_min  = t["minute"].get<int>();
-    target_tm.tm_sec  = 0;
-
-    auto target_tp = std::chrono::system_clock::from_time_t(std::mktime(&target_tm));
-    auto sync_tp = target_tp - std::chrono::seconds(90);
-    auto token_tp = target_tp - std::chrono::seconds(60);
+    TimeZone target_zone;
+    if (!target_zone.load(t.value("zone", "Europe/Istanbul"))) {
+        std::cerr << "[Fatal] Time zone: " << target_zone.last_error() << std::endl;
+        return 1;
+    }
+    long long target_utc_s = target_zone.to_utc(t["year"].get<int>(), t["month"].get<int>(), t["day"].get<int>(),
+                                                t["hour"].get<int>(), t["minute"].get<int>(), t.value("second", 0));
+    TargetTime target;
+    target.utc_ns = target_utc_s * 1000000000LL;
+    target.offset_s = target_zone.offset_at(target_utc_s);
+    target.zone = target_zone.name();
+
+    const auto target_tp = target.time_point();
+    const auto sync_tp = target_tp - std::chrono::seconds(90);
+    {
+        std::time_t utc = (std::time_t)target_utc_s;
+        char utc_buf[32];
+        std::strftime(utc_buf, sizeof(utc_buf), "%Y-%m-%d %H:%M:%S", std::gmtime(&utc));
+        std::cout << "[System] Target " << target.zone << " (" << TimeZone::format_offset(target.offset_s) << ") = "
+                  << utc_buf << " UTC" << std::endl;
+    }
 
     if(flags.test) std::cout << "[Warning] Test mode enabled, immediately sending request" << std::endl;
 
-    if(std::chrono::system_clock::now() < sync_tp && !flags.test && !flags.local){
+    // Token: from the saved session when it is still alive (one request), acquired now otherwise.
+    // The refresher replaces it in the background when its exp claim says it would not last
+    json auth_cfg = config.value("auth", json::object());
+    TokenCacheOptions token_opts;
+    token_opts.path = auth_cfg.value("session_file", token_opts.path);
+    token_opts.encrypt = auth_cfg.value("encrypt_cache", true);
+    token_opts.refresh_margin_s = auth_cfg.value("refresh_margin_s", 120);
+    token_opts.retry_s = auth_cfg.value("retry_s", 10);
+    AuthOptions login_opts;
+    json step_timeouts = auth_cfg.value("step_timeout_ms", json::object());
+    for (int i = 0; i < AUTH_STEPS; i++) {
+        login_opts.timeout_ms[i] = step_timeouts.value(auth_step_name((AuthStep)i), login_opts.timeout_ms[i]);
+    }
+    login_opts.retries = auth_cfg.value("step_retries", 2);
+    login_opts.backoff_ms = auth_cfg.value("retry_backoff_ms", 250);
+    TokenFetcher itu_auth(pool, login_opts);
+    TokenCache tokens(itu_auth, itu_clock, config["account"]["username"], config["account"]["password"], flags.debug, token_opts);
+    const auto token_needed_tp = target_tp + std::chrono::seconds(auth_cfg.value("valid_after_s", 60));
+    const auto token_cutoff_tp = target_tp - std::chrono::seconds(auth_cfg.value("cutoff_s", 30));
+
+    if(tokens.load()){
+        if(tokens.get_source() == "cache") std::cout << "[Auth] Saved session expired, using its JWT." << std::endl;
+    }else{
+        if(flags.debug) std::cout << "[Debug] Saved session not used: " << tokens.last_error() << std::endl;
+        if(!tokens.acquire()) std::cout << "[Warning] " << tokens.last_error() << std::endl;
+    }
+    if(!flags.test) tokens.start_refresh(token_needed_tp, token_cutoff_tp);
+
+    // Keep measuring offset and drift in the background until shortly before the target.
+    // The probes run on a transport of their own, the threads never share a connection
+    const int discipline_s = clock_cfg.value("discipline_interval_s", 15);
+    if(!flags.test && !flags.local && discipline_s > 0){
+        auto lane = make_transport(backend, user_agent, net_opts);
+        if(lane) lane->set_resolver(&dns);
+        itu_clock.start_discipline(std::move(lane), "obs.itu.edu.tr", target_tp - std::chrono::seconds(5), discipline_s * 1000);
+    }
+
+    if(itu_clock.ms_until(sync_tp) > 0 && !flags.test && !flags.local){
         std::cout << "[System] Wait until 90s..." << std::endl;
-        std::this_thread::sleep_until(sync_tp);
+        itu_clock.sleep_until(sync_tp);
         
         std::cout << "[Clock] Re-Sync with ITU Server..." << std::endl;
-        itu_clock.sync_with_server(hConnect);
+        if(itu_clock.has_probe_lane()){
+            itu_clock.sync_with_server();
+        }else{
+            auto session = tokens.hold_session();
+            itu_clock.sync_with_server(*pool.acquire("obs.itu.edu.tr"));
+        }
     }
     else if(!flags.local){
         std::cout << "[Warning] Less than 90s remains. Skipping resync..." << std::endl;
     }
 
-    // Wait for Pre-Fetch Phase
-    if(!flags.test){
-        std::cout << "[System] Waiting until 60s before target for native token acquisition..." << std::endl;
-        std::this_thread::sleep_until(token_tp);
-    }
-
-    // Acquire Token 
-    std::string auth_header = itu_auth.get_bearer_token(
-        config["account"]["username"], 
-        config["account"]["password"],
-        flags.debug // Print extra logs if debug is true
-    );
-
-    if (auth_header.find("ERROR") != std::string::npos) {
-        std::cerr << "[Critical] " << auth_header << std::endl;
-        return 1;
-    }
-    std::cout << "[Success] JWT acquired." << std::endl;
-    if(flags.debug) std::cout << "[Debug] Auth token: \n" << auth_header << std::endl;
-
     // Prepare Request Payload (Ensure ECRN/SCRN are arrays)
     std::cout << "[JSON] Preparing add CRN" << std::endl;
     json body_json;
@@ -140,60 +238,192 @@ int main(int argc, char *argv[]) {
     }
     
     std::string body_data = body_json.dump();
-    std::wstring wToken(auth_header.begin(), auth_header.end());
+
+    // Arm Phase: negotiate the fire connection a few seconds early and keep it warm
+    json fire_cfg = config.value("fire", json::object());
+    const int arm_lead_ms = fire_cfg.value("arm_seconds", 5) * 1000;
+    auto ms_to_target = [&]() { return itu_clock.ms_until(target_tp); };
+
+    if(!flags.test){
+        std::cout << "[System] Waiting until " << arm_lead_ms / 1000 << "s before target to arm the connection..." << std::endl;
+        itu_clock.sleep_until(target_tp - std::chrono::milliseconds(arm_lead_ms));
+    }
+
+    // DNS stays pinned from here on, no background lookups during the fire window
+    dns.stop_refresh();
+    itu_clock.stop_discipline();
+
+    // The pool is the main thread's again. A token that does not last through the fire gets one
+    // last login here, which only happens if every background attempt failed. One too short-lived
+    // for auth.valid_after_s was already replaced at the cutoff, a login now would not reach it either
+    tokens.stop_refresh();
+    if(!tokens.valid_at(flags.test ? std::chrono::system_clock::now() : target_tp)){
+        std::cout << "[Warning] No JWT valid through the fire, logging in now..." << std::endl;
+        if(!tokens.acquire()){
+            std::cerr << "[Critical] " << tokens.last_error() << std::endl;
+            return 1;
+        }
+    } else if(!flags.test && !tokens.valid_at(token_needed_tp)){
+        std::cout << "[Warning] JWT expires less than auth.valid_after_s after the target, its lifetime is too short." << std::endl;
+    }
+    std::string auth_header = tokens.bearer();
+    if(flags.debug) std::cout << "[Debug] Auth token: \n" << auth_header << std::endl;
 
     // Build Comprehensive Headers (Browser Fetch)
-    std::wstring headers = 
-        L"Authorization: " + wToken + L"\r\n" +
-        L"Content-Type: application/json\r\n" +
-        L"Accept: application/json, text/plain, */*\r\n" +
-        L"Accept-Language: tr-TR,tr;q=0.9,en-US;q=0.8,en;q=0.7\r\n" +
-        L"Referer: https://obs.itu.edu.tr/ogrenci/DersKayitIslemleri/DersKayit\r\n" +
-        L"sec-ch-ua: \"Not(A:Brand\";v=\"8\", \"Chromium\";v=\"144\", \"Google Chrome\";v=\"144\"\r\n" +
-        L"sec-ch-ua-mobile: ?0\r\n" +
-        L"sec-ch-ua-platform: \"Windows\"\r\n" +
-        L"sec-fetch-dest: empty\r\n" +
-        L"sec-fetch-mode: cors\r\n" +
-        L"sec-fetch-site: same-origin\r\n";
+    std::string headers = 
+        "Authorization: " + auth_header + "\r\n" +
+        "Content-Type: application/json\r\n" +
+        "Accept: application/json, text/plain, */*\r\n" +
+        "Accept-Language: tr-TR,tr;q=0.9,en-US;q=0.8,en;q=0.7\r\n" +
+        "Referer: https://obs.itu.edu.tr/ogrenci/DersKayitIslemleri/DersKayit\r\n" +
+        "sec-ch-ua: \"Not(A:Brand\";v=\"8\", \"Chromium\";v=\"144\", \"Google Chrome\";v=\"144\"\r\n" +
+        "sec-ch-ua-mobile: ?0\r\n" +
+        "sec-ch-ua-platform: \"Windows\"\r\n" +
+        "sec-fetch-dest: empty\r\n" +
+        "sec-fetch-mode: cors\r\n" +
+        "sec-fetch-site: same-origin\r\n";
+
+    // The fire connection is the one the login chain used, cookies and socket included
+    auto connection = pool.acquire("obs.itu.edu.tr");
+    if (!connection) {
+        std::cerr << "[Fatal] Could not connect to servers." << std::endl;
+        return 1;
+    }
+
+    ArmedConnection armed(*connection, fire_cfg.value("probe_interval_ms", 2000));
+    if(!armed.arm()) std::cout << "[Warning] Could not arm the connection, request will open a cold one." << std::endl;
+
+    // Freeze the exact request bytes into one locked buffer and render them on the armed connection
+    FirePlan plan(headers, body_data, fire_cfg.value("split_tail_bytes", 1));
+    if(flags.debug && !plan.is_locked()) std::cout << "[Debug] Fire buffer could not be locked in memory, continuing unlocked." << std::endl;
+
+    FireRequest fire_req(*connection, plan);
+    ResponseBuffer fire_response; // Allocated now, so reading the result does not touch the heap
+    if(!fire_req.prepare()) std::cout << "[Warning] Could not prepare the request (" << fire_req.last_error() << "), retrying at fire time." << std::endl;
+
+    // Split mode streams the request ahead of time and holds back the last body bytes until T0
+    const FireMode fire_mode = parse_fire_mode(fire_cfg.value("mode", "full"));
+    // Not before the quiet window: by then keep_alive has settled the last probe, so the head is not
+    // pipelined behind an unanswered HEAD on HTTP/1.1
+    int stage_ms = fire_cfg.value("stage_ms", 1000);
+    if(stage_ms > ArmedConnection::QUIET_MS) stage_ms = ArmedConnection::QUIET_MS;
+
+    // Lead time: fixed, or the expected one-way latency so the request arrives at T0 instead of leaving at it
+    const LeadMode lead_mode = parse_lead_mode(fire_cfg.value("lead", "fixed"));
+    const double fixed_lead_ms = fire_cfg.value("lead_ms", 0.0);
+    const double max_lead_ms = fire_cfg.value("max_lead_ms", 15.0);
+    if(fire_mode == FireMode::Split && flags.test) fire_req.stream_head();
+
+    // The final wait and the write. In real-time mode they run on a dedicated thread that is
+    // started (and allocated) here and released at the end of the wait loop
+    bool fired = false;
+    bool received = false;
+    double sent_local = 0, answered_local = 0;
+    unsigned long long fired_allocs = 0;
+    auto fire_path = [&]() {
+        if(!flags.test) itu_clock.wait_until(target_tp);
+        fired = fire_req.fire();
+        sent_local = SystemClock::local_ms();
+        fired_allocs = allocation_count();
+        // Waiting for the answer right here times it without any console output in between
+        if(fired){
+            received = fire_req.response().receive();
+            answered_local = SystemClock::local_ms();
+        }
+    };
+
+    std::unique_ptr<RealtimeThread> fire_thread;
+    if(fire_cfg.value("realtime", false)){
+        RealtimeOptions rt_options;
+        rt_options.cpu = fire_cfg.value("realtime_cpu", clock_cfg.value("spin_cpu", -1));
+        rt_options.priority = fire_cfg.value("realtime_priority", 80);
+        fire_thread = std::make_unique<RealtimeThread>(rt_options);
+        fire_thread->start(fire_path);
+        std::cout << "[Realtime] Fire thread ready: " << fire_thread->describe() << std::endl;
+        if(!fire_thread->fallback_notes().empty()) std::cout << "[Warning] Real-time settings fell back: " << fire_thread->fallback_notes() << std::endl;
+    }
+
+    // From the last keep-alive probe on, nothing may touch the heap
+    unsigned long long quiet_allocs = allocation_count();
 
     // Final Wait
-    if(!flags.test) itu_clock.wait_until(t["year"], t["month"], t["day"], t["hour"], t["minute"]);
+    if(!flags.test){
+        long long remaining;
+        bool quiet = false;
+        while((remaining = ms_to_target()) > 50){
+            // Settles an unanswered probe at the quiet window before the allocation baseline is taken
+            if(!fire_req.is_streamed()){
+                armed.keep_alive(remaining);
+                // A reconnect leaves the prepared frames on a dead session, render them again now
+                fire_req.refresh();
+            }
+            if(!quiet && remaining <= ArmedConnection::QUIET_MS){
+                quiet = true;
+                quiet_allocs = allocation_count();
+            }
+            if(fire_mode == FireMode::Split && remaining <= stage_ms && !fire_req.is_streamed()) fire_req.stream_head();
+            transport->poll(20); // Answers to keep-alive probes are handled here
+        }
+        if(!quiet) quiet_allocs = allocation_count();
+    }
+
+    // From the freshest round trips, set before the fire path starts its final wait. The estimate
+    // is kept in fixed mode too, it predicts the arrival time in the log
+    LeadEstimate lead = estimate_lead(itu_clock.get_best_rtt_ms(), armed.best_rtt_ms(), itu_clock.get_error_ms(), max_lead_ms);
+    if(lead_mode == LeadMode::Fixed) lead.lead_ms = fixed_lead_ms;
+    itu_clock.set_lead_ms(lead.lead_ms);
+
+    // Printed here, the fire path itself stays off the console
+    if(!flags.test) std::cout << "[Clock] Waiting for target time..." << std::endl;
+    if(fire_thread){
+        fire_thread->release();
+        fire_thread->join();
+    }else{
+        fire_path();
+    }
+    unsigned long long fire_allocs = fired_allocs - quiet_allocs;
 
     // Send registration request
     std::cout << ">>> FIRING REGISTRATION REQUEST <<<" << std::endl;
+    double wake_error_us;
+    if(itu_clock.wake_engine().last_error(wake_error_us)) std::cout << "[Clock] Woke " << wake_error_us << "us after the deadline." << std::endl;
+    if(fire_allocs > 0) std::cout << "[Warning] " << fire_allocs << " heap allocations on the fire path." << std::endl;
+    else if(flags.debug) std::cout << "[Debug] Fire path completed without heap allocations." << std::endl;
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", L"/api/ders-kayit/v21", 
-                                            NULL, WINHTTP_NO_REFERER, 
-                                            WINHTTP_DEFAULT_ACCEPT_TYPES, 
-                                            WINHTTP_FLAG_SECURE);
-
-    if (!WinHttpSendRequest(hRequest, headers.c_str(), (DWORD)-1L, 
-                           (LPVOID)body_data.c_str(), (DWORD)body_data.length(), 
-                           (DWORD)body_data.length(), 0)) {
-        DWORD err = GetLastError();
-        std::cerr << "[Error] WinHttpSendRequest failed: " << err << std::endl;
-
-        if(err == ERROR_WINHTTP_CANNOT_CONNECT) std::cerr << "Cannot connect to server." << std::endl;
-        if(err == ERROR_WINHTTP_SECURE_FAILURE) std::cerr << "SSL/TLS handshake error." << std::endl;
+    if (!fired) {
+        std::cerr << "[Error] Send failed: " << fire_req.last_error() << std::endl;
     } else {
-        if (!WinHttpReceiveResponse(hRequest, NULL)) {
-            std::cerr << "[Error] WinHttpReceiveResponse failed: " << GetLastError() << std::endl;
+        HttpRequest& request = fire_req.response();
+        if (!received) {
+            std::cerr << "[Error] Receive failed: " << request.last_error() << std::endl;
         } else {
-            DWORD code = 0, size = sizeof(code);
-            WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER, 
-                                WINHTTP_HEADER_NAME_BY_INDEX, &code, &size, WINHTTP_NO_HEADER_INDEX);
-            std::cout << "[Result] Server Response Code: " << code << std::endl;
-
-            std::string response_raw;
-            DWORD dwSize = 0;
-            do{
-                WinHttpQueryDataAvailable(hRequest, &dwSize);
-                if(dwSize == 0) break;
-                std::vector<char> buffer(dwSize);
-                DWORD dwDownloaded = 0;
-                WinHttpReadData(hRequest, (LPVOID)&buffer[0], dwSize, &dwDownloaded);
-                response_raw.append(buffer.data(), dwDownloaded);
-            }while(dwSize > 0);
+            std::cout << "[Result] Server Response Code: " << request.status_code() << std::endl;
+
+            // Where the request should have landed on the server clock, next to what the server stamped
+            if(!flags.test){
+                double target_ms = std::chrono::duration<double, std::milli>(target_tp.time_since_epoch()).count();
+                double sent_ms = itu_clock.server_ms_at(sent_local) - target_ms;
+                double arrival_ms = sent_ms + lead.one_way_ms;
+                std::string server_date = request.query_header("Date");
+                std::cout << std::fixed << std::setprecision(1)
+                          << "[Timing] Lead " << lead.lead_ms << "ms (" << (lead_mode == LeadMode::Adaptive ? "adaptive" : "fixed")
+                          << ", RTT " << lead.rtt_ms << "ms from " << lead.source << ")" << std::endl
+                          << "[Timing] Written at T0" << std::showpos << sent_ms << "ms, predicted arrival T0" << arrival_ms
+                          << std::noshowpos << "ms, answered after " << answered_local - sent_local << "ms, server Date: "
+                          << server_date << std::defaultfloat << std::endl;
+
+                auto& timing = report.section("fire");
+                timing["lead_mode"] = lead_mode == LeadMode::Adaptive ? "adaptive" : "fixed";
+                timing["lead_ms"] = lead.lead_ms;
+                timing["rtt_ms"] = lead.rtt_ms;
+                timing["rtt_source"] = lead.source;
+                timing["written_ms"] = sent_ms;
+                timing["predicted_arrival_ms"] = arrival_ms;
+                timing["answered_after_ms"] = answered_local - sent_local;
+                timing["server_date"] = server_date;
+            }
+
+            std::string_view response_raw = request.read_body(fire_response);
 
             if(flags.debug) std::cout << "[Debug] Raw Response: \n" << response_raw << std::endl;
 
@@ -217,10 +447,16 @@ int main(int argc, char *argv[]) {
         }
     }
 
-    // Cleanup
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
+    pool.report();
+
+    itu_clock.fill_report(report);
+    tokens.fill_report(report);
+    itu_auth.fill_report(report);
+    if(fire_thread) fire_thread->fill_report(report);
+    dns.fill_report(report);
+    transport->fill_report(report);
+    if(flags.debug) report.print();
+    if(report.save("data/last_run.json")) std::cout << "[System] Run report saved to data/last_run.json" << std::endl;
 
     std::cout << "[System] Press Enter to exit." << std::endl;
     std::cin.get();
@@ -0,0 +1,127 @@
+#include "memory.hpp"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// --- LOCKED BUFFER ---
+
+LockedBuffer::LockedBuffer(size_t capacity) : cap(capacity) {
+#ifdef _WIN32
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    size_t page = si.dwPageSize;
+#else
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    mapped = ((capacity ? capacity : 1) + page - 1) / page * page;
+
+#ifdef _WIN32
+    buf = (char*)VirtualAlloc(NULL, mapped, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!buf) {
+        cap = 0;
+        return;
+    }
+    std::memset(buf, 0, mapped); // Pre-fault every page
+    locked = VirtualLock(buf, mapped) != 0;
+#else
+    void* p = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        cap = 0;
+        return;
+    }
+    buf = (char*)p;
+    std::memset(buf, 0, mapped); // Pre-fault every page
+    locked = mlock(buf, mapped) == 0;
+#endif
+}
+
+LockedBuffer::~LockedBuffer() {
+    if (!buf) return;
+#ifdef _WIN32
+    if (locked) VirtualUnlock(buf, mapped);
+    VirtualFree(buf, 0, MEM_RELEASE);
+#else
+    if (locked) munlock(buf, mapped);
+    munmap(buf, mapped);
+#endif
+}
+
+bool LockedBuffer::append(const char* data, size_t n) {
+    if (n > cap - len) return false;
+    if (n > 0) std::memcpy(buf + len, data, n);
+    len += n;
+    return true;
+}
+
+// --- RESPONSE BUFFER ---
+
+ResponseBuffer::ResponseBuffer(size_t initial) {
+    if (initial > 0 && (buf = (char*)std::malloc(initial))) cap = initial;
+}
+
+ResponseBuffer::~ResponseBuffer() {
+    std::free(buf);
+}
+
+char* ResponseBuffer::prepare(size_t n) {
+    if (n > cap - len) {
+        // Doubling keeps the number of grows logarithmic in the largest body
+        size_t want = cap ? cap : 4096;
+        while (want - len < n) want *= 2;
+        char* grown = (char*)std::realloc(buf, want);
+        if (!grown) return nullptr;
+        buf = grown;
+        cap = want;
+        grows++;
+    }
+    return buf + len;
+}
+
+bool ResponseBuffer::append(const char* data, size_t n) {
+    char* dst = prepare(n);
+    if (!dst) return false;
+    if (n > 0) std::memcpy(dst, data, n);
+    len += n;
+    return true;
+}
+
+// --- ALLOCATION COUNTING HOOK ---
+
+static std::atomic<unsigned long long> allocations{0};
+
+unsigned long long allocation_count() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
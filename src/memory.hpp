@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+
+// Page-aligned buffer for the fire path. The pages are touched up front so no page fault
+// lands on the critical timeline, and pinned in RAM (mlock / VirtualLock) where permitted.
+class LockedBuffer {
+private:
+    char* buf = nullptr;
+    size_t len = 0;
+    size_t cap = 0;
+    size_t mapped = 0;
+    bool locked = false;
+
+public:
+    explicit LockedBuffer(size_t capacity);
+    ~LockedBuffer();
+    LockedBuffer(const LockedBuffer&) = delete;
+    LockedBuffer& operator=(const LockedBuffer&) = delete;
+
+    // Copies bytes to the end of the buffer, false if they do not fit
+    bool append(const char* data, size_t n);
+
+    char* data() { return buf; }
+    const char* data() const { return buf; }
+    size_t size() const { return len; }
+    size_t capacity() const { return cap; }
+    bool is_locked() const { return locked; }
+};
+
+// Growable byte arena that response bodies are read into. It is reused across requests, so
+// once it has grown to the largest body seen a read costs no allocation at all. Views handed
+// out stay valid until the next clear() or growth.
+class ResponseBuffer {
+private:
+    char* buf = nullptr;
+    size_t len = 0;
+    size_t cap = 0;
+    unsigned long long grows = 0;
+
+public:
+    explicit ResponseBuffer(size_t initial = 64 * 1024);
+    ~ResponseBuffer();
+    ResponseBuffer(const ResponseBuffer&) = delete;
+    ResponseBuffer& operator=(const ResponseBuffer&) = delete;
+
+    void clear() { len = 0; }
+
+    // Room for n more bytes at the end, to be filled and then committed. nullptr if out of memory
+    char* prepare(size_t n);
+    void commit(size_t n) { len += n; }
+    bool append(const char* data, size_t n);
+
+    std::string_view view() const { return std::string_view(buf, len); }
+    size_t size() const { return len; }
+    size_t capacity() const { return cap; }
+    unsigned long long growth_count() const { return grows; }
+};
+
+// Number of operator new calls so far. The fire path compares two readings to make sure
+// nothing between arming and the final write touches the heap.
+unsigned long long allocation_count();
@@ -0,0 +1,42 @@
+#include "pool.hpp"
+#include <iostream>
+
+// --- LEASE ---
+
+ConnectionPool::Lease::Lease(ConnectionPool* pool, const std::string& host, std::unique_ptr<HttpConnection> conn)
+    : pool(pool), host(host), conn(std::move(conn)) {}
+
+ConnectionPool::Lease::~Lease() {
+    if (conn) pool->release(host, std::move(conn));
+}
+
+// --- POOL ---
+
+ConnectionPool::ConnectionPool(HttpTransport& transport) : transport(transport) {}
+
+ConnectionPool::Lease ConnectionPool::acquire(const std::string& host, int port) {
+    std::string key = host + ":" + std::to_string(port);
+    HostEntry& entry = hosts[key];
+
+    if (!entry.idle.empty()) {
+        std::unique_ptr<HttpConnection> conn = std::move(entry.idle.back());
+        entry.idle.pop_back();
+        entry.reused++;
+        return Lease(this, key, std::move(conn));
+    }
+
+    std::unique_ptr<HttpConnection> conn = transport.connect(host, port);
+    if (conn) entry.opened++;
+    return Lease(this, key, std::move(conn));
+}
+
+void ConnectionPool::release(const std::string& host, std::unique_ptr<HttpConnection> conn) {
+    hosts[host].idle.push_back(std::move(conn));
+}
+
+void ConnectionPool::report() const {
+    for (const auto& [host, entry] : hosts) {
+        std::cout << "[Pool] " << host << ": " << entry.opened << " connection(s) opened, "
+                  << entry.reused << " reuse(s)" << std::endl;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "transport.hpp"
+
+// Per-host pool of keep-alive connections on one shared transport session. The clock sync,
+// the login chain and the registration request all draw from it, so the socket (and the
+// cookies) negotiated during login are the ones the POST goes out on.
+class ConnectionPool {
+private:
+    struct HostEntry {
+        std::vector<std::unique_ptr<HttpConnection>> idle;
+        int opened = 0;  // Connections created for this host
+        int reused = 0;  // Leases served from an idle connection
+    };
+
+    HttpTransport& transport;
+    std::map<std::string, HostEntry> hosts;
+
+    void release(const std::string& host, std::unique_ptr<HttpConnection> conn);
+
+public:
+    // Exclusive use of a pooled connection, handed back to the pool on destruction
+    class Lease {
+    private:
+        ConnectionPool* pool;
+        std::string host;
+        std::unique_ptr<HttpConnection> conn;
+
+    public:
+        Lease(ConnectionPool* pool, const std::string& host, std::unique_ptr<HttpConnection> conn);
+        Lease(Lease&&) = default;
+        Lease& operator=(Lease&&) = delete;
+        ~Lease();
+
+        HttpConnection* operator->() { return conn.get(); }
+        HttpConnection& operator*() { return *conn; }
+        explicit operator bool() const { return conn != nullptr; }
+    };
+
+    explicit ConnectionPool(HttpTransport& transport);
+
+    // Reuses an idle connection to host if there is one, opens a new one otherwise
+    Lease acquire(const std::string& host, int port = 443);
+
+    HttpTransport& get_transport() { return transport; }
+
+    // Prints opened/reused counts per host
+    void report() const;
+};
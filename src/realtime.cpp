@@ -0,0 +1,145 @@
+#include "realtime.hpp"
+#include "report.hpp"
+#include <cstring>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+// --- INTERNAL HELPERS ---
+
+static const size_t STACK_PREFAULT = 64 * 1024;
+#ifdef _WIN32
+static const SIZE_T WORKING_SET_MIN = 64 * 1024 * 1024;
+#endif
+
+// Touches the top of the stack so the fire path does not take page faults on it
+static void prefault_stack() {
+    volatile char pad[STACK_PREFAULT];
+    for (size_t i = 0; i < STACK_PREFAULT; i += 4096) pad[i] = 0;
+    (void)pad;
+}
+
+static void add_note(std::string& notes, const std::string& note) {
+    if (!notes.empty()) notes += "; ";
+    notes += note;
+}
+
+// --- CLASS METHODS ---
+
+RealtimeThread::RealtimeThread(const RealtimeOptions& options) : options(options) {}
+
+RealtimeThread::~RealtimeThread() {
+    // A thread that was never released exits without running the job
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        cancelled = !released;
+        released = true;
+    }
+    wake.notify_all();
+    join();
+#ifndef _WIN32
+    if (memory_locked) munlockall();
+#endif
+}
+
+void RealtimeThread::setup() {
+    // Memory first: the lock covers this thread's stack, which only exists from here on.
+    // MCL_FUTURE is left out on purpose, with a low RLIMIT_MEMLOCK it makes later allocations fail
+    if (options.lock_memory) {
+#ifdef _WIN32
+        SIZE_T min_ws = 0, max_ws = 0;
+        HANDLE process = GetCurrentProcess();
+        if (GetProcessWorkingSetSize(process, &min_ws, &max_ws)) {
+            if (min_ws < WORKING_SET_MIN) min_ws = WORKING_SET_MIN;
+            if (max_ws < min_ws * 2) max_ws = min_ws * 2;
+            memory_locked = SetProcessWorkingSetSizeEx(process, min_ws, max_ws, QUOTA_LIMITS_HARDWS_MIN_ENABLE) != 0;
+        }
+        if (!memory_locked) add_note(notes, "working set not locked (error " + std::to_string(GetLastError()) + ")");
+#else
+        memory_locked = mlockall(MCL_CURRENT) == 0;
+        if (!memory_locked) add_note(notes, std::string("mlockall failed: ") + std::strerror(errno) + " (RLIMIT_MEMLOCK)");
+#endif
+    }
+
+    if (options.cpu >= 0) {
+#ifdef _WIN32
+        pinned = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << options.cpu) != 0;
+        if (!pinned) add_note(notes, "cannot pin to cpu " + std::to_string(options.cpu));
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options.cpu, &set);
+        pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+        if (!pinned) add_note(notes, "cannot pin to cpu " + std::to_string(options.cpu) + ": " + std::strerror(errno));
+#endif
+    }
+
+#ifdef _WIN32
+    elevated = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+    if (!elevated) add_note(notes, "TIME_CRITICAL priority denied");
+#else
+    sched_param param{};
+    param.sched_priority = options.priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    elevated = rc == 0;
+    if (!elevated) add_note(notes, std::string("SCHED_FIFO denied: ") + std::strerror(rc) + " (needs CAP_SYS_NICE or an rtprio limit)");
+#endif
+
+    prefault_stack();
+}
+
+void RealtimeThread::start(std::function<void()> fn) {
+    job = std::move(fn);
+    worker = std::thread([this]() {
+        setup();
+
+        std::unique_lock<std::mutex> guard(lock);
+        ready = true;
+        wake.notify_all();
+        wake.wait(guard, [this]() { return released; });
+        bool run = !cancelled;
+        guard.unlock();
+
+        if (run && job) job();
+    });
+
+    std::unique_lock<std::mutex> guard(lock);
+    wake.wait(guard, [this]() { return ready; });
+}
+
+void RealtimeThread::release() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        released = true;
+    }
+    wake.notify_all();
+}
+
+void RealtimeThread::join() {
+    if (worker.joinable()) worker.join();
+}
+
+std::string RealtimeThread::describe() const {
+    std::string line = pinned ? "cpu " + std::to_string(options.cpu) : "any cpu";
+#ifdef _WIN32
+    line += elevated ? ", TIME_CRITICAL" : ", normal priority";
+#else
+    line += elevated ? ", SCHED_FIFO " + std::to_string(options.priority) : ", normal scheduling";
+#endif
+    line += memory_locked ? ", memory locked" : ", memory unlocked";
+    return line;
+}
+
+void RealtimeThread::fill_report(RunReport& report) const {
+    auto& rt = report.section("realtime");
+    rt["cpu"] = pinned ? options.cpu : -1;
+    rt["elevated"] = elevated;
+    rt["memory_locked"] = memory_locked;
+    rt["status"] = describe();
+    if (!notes.empty()) rt["fallbacks"] = notes;
+}
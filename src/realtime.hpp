@@ -0,0 +1,59 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class RunReport;
+
+struct RealtimeOptions {
+    int cpu = -1;            // Core the thread is pinned to, -1 leaves the affinity alone
+    int priority = 80;       // SCHED_FIFO priority (1-99) on Linux. Windows always uses TIME_CRITICAL
+    bool lock_memory = true; // Lock the process' pages in RAM (mlockall / working set minimum)
+};
+
+// Dedicated thread for the fire path (final wait + registration write). The thread is started
+// early, applies its settings and parks. release() lets the job run, so nothing on the critical
+// timeline creates threads or allocates. Each elevation needs privileges the bot may not have
+// (CAP_SYS_NICE / rtprio, RLIMIT_MEMLOCK, ...); whatever is denied is logged and skipped and
+// the job runs with the rest.
+class RealtimeThread {
+private:
+    RealtimeOptions options;
+    std::function<void()> job;
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool ready = false;
+    bool released = false;
+    bool cancelled = false;
+
+    // What was actually granted
+    bool pinned = false;
+    bool elevated = false;
+    bool memory_locked = false;
+    std::string notes;
+
+    void setup();
+
+public:
+    explicit RealtimeThread(const RealtimeOptions& options);
+    // Joins the thread. If it was never released the job is skipped
+    ~RealtimeThread();
+    RealtimeThread(const RealtimeThread&) = delete;
+    RealtimeThread& operator=(const RealtimeThread&) = delete;
+
+    // Spawns the thread and returns once its settings are applied and it is parked
+    void start(std::function<void()> job);
+    // Runs the parked job
+    void release();
+    void join();
+
+    // Single status line, e.g. "cpu 3, SCHED_FIFO 80, memory locked"
+    std::string describe() const;
+    // Reasons for the settings that fell back, empty if everything was granted
+    const std::string& fallback_notes() const { return notes; }
+
+    void fill_report(RunReport& report) const;
+};
@@ -0,0 +1,14 @@
+#include "report.hpp"
+#include <fstream>
+#include <iostream>
+
+void RunReport::print() const {
+    std::cout << "\n--- Run Report ---\n" << data.dump(2) << std::endl;
+}
+
+bool RunReport::save(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) return false;
+    out << data.dump(2) << std::endl;
+    return true;
+}
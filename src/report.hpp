@@ -0,0 +1,17 @@
+#pragma once
+#include <string>
+#include "../include/nlohmann_json.hpp"
+
+// Collects measurements from every phase of a run. Saved as JSON next to the config so
+// timings can be compared across runs and hosts.
+class RunReport {
+private:
+    nlohmann::json data = nlohmann::json::object();
+
+public:
+    // Section for one subsystem, e.g. report.section("dns")["obs.itu.edu.tr"] = ...
+    nlohmann::json& section(const std::string& name) { return data[name]; }
+
+    void print() const;
+    bool save(const std::string& path) const;
+};
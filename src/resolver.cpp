@@ -0,0 +1,185 @@
+#include "resolver.hpp"
+#ifndef _WIN32
+#include <netdb.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#endif
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#pragma comment(lib, "ws2_32.lib")
+#endif
+
+// --- INTERNAL HELPERS ---
+
+static bool same_address(const ResolvedAddress& a, const ResolvedAddress& b) {
+    return a.len == b.len && std::memcmp(&a.addr, &b.addr, a.len) == 0;
+}
+
+static bool contains_all(const std::vector<ResolvedAddress>& a, const std::vector<ResolvedAddress>& b) {
+    for (const ResolvedAddress& x : a) {
+        bool found = false;
+        for (const ResolvedAddress& y : b) found = found || same_address(x, y);
+        if (!found) return false;
+    }
+    return true;
+}
+
+// Compared as sets: round-robin DNS hands out the same addresses in a rotating order
+static bool same_addresses(const std::vector<ResolvedAddress>& a, const std::vector<ResolvedAddress>& b) {
+    return contains_all(a, b) && contains_all(b, a);
+}
+
+std::vector<ResolvedAddress> system_resolve(const std::string& host, int port, double& elapsed_ms) {
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    auto t1 = std::chrono::steady_clock::now();
+    addrinfo* res = nullptr;
+    int rc = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &res);
+    elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t1).count();
+
+    std::vector<ResolvedAddress> out;
+    if (rc != 0) return out;
+    for (addrinfo* ai = res; ai; ai = ai->ai_next) {
+        ResolvedAddress a = {};
+        std::memcpy(&a.addr, ai->ai_addr, ai->ai_addrlen);
+        a.len = (socklen_t)ai->ai_addrlen;
+        out.push_back(a);
+    }
+    freeaddrinfo(res);
+    return out;
+}
+
+std::string ResolvedAddress::to_string() const {
+    char buf[INET6_ADDRSTRLEN] = {};
+    if (addr.ss_family == AF_INET) {
+        inet_ntop(AF_INET, &((const sockaddr_in*)&addr)->sin_addr, buf, sizeof(buf));
+    } else if (addr.ss_family == AF_INET6) {
+        inet_ntop(AF_INET6, &((const sockaddr_in6*)&addr)->sin6_addr, buf, sizeof(buf));
+    }
+    return buf;
+}
+
+// --- CLASS METHODS ---
+
+Resolver::Resolver() {
+#ifdef _WIN32
+    WSADATA wsa;
+    WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+}
+
+Resolver::~Resolver() {
+    stop_refresh();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+bool Resolver::refresh(const std::string& key) {
+    std::string host;
+    int port;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        host = cache[key].host;
+        port = cache[key].port;
+    }
+
+    // The lookup itself runs unlocked so the fire path never waits behind DNS
+    double ms = 0;
+    std::vector<ResolvedAddress> addrs = system_resolve(host, port, ms);
+
+    std::lock_guard<std::mutex> guard(lock);
+    Entry& e = cache[key];
+    e.lookups++;
+    e.last_ms = ms;
+    if (e.lookups == 1) e.first_ms = ms;
+    if (ms > e.worst_ms) e.worst_ms = ms;
+
+    // A failed re-validation keeps the previous pin
+    if (addrs.empty()) {
+        e.failures++;
+        return !e.addrs.empty();
+    }
+    // Only a new set of addresses moves the pin, a rotated order keeps the one in use
+    if (!e.addrs.empty() && same_addresses(e.addrs, addrs)) return true;
+    if (!e.addrs.empty()) {
+        e.changes++;
+        std::cout << "[DNS] " << host << " moved to " << addrs[0].to_string() << std::endl;
+    }
+    e.addrs = std::move(addrs);
+    return true;
+}
+
+bool Resolver::resolve(const std::string& host, int port) {
+    std::string key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        Entry& e = cache[key];
+        e.host = host;
+        e.port = port;
+    }
+    return refresh(key);
+}
+
+std::vector<ResolvedAddress> Resolver::lookup(const std::string& host, int port) {
+    std::string key = host + ":" + std::to_string(port);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        auto it = cache.find(key);
+        if (it != cache.end() && !it->second.addrs.empty()) return it->second.addrs;
+    }
+    resolve(host, port);
+
+    std::lock_guard<std::mutex> guard(lock);
+    return cache[key].addrs;
+}
+
+void Resolver::start_refresh(int interval_ms) {
+    if (worker.joinable()) return;
+    stopping = false;
+
+    worker = std::thread([this, interval_ms]() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!wake.wait_for(guard, std::chrono::milliseconds(interval_ms), [this]() { return stopping; })) {
+            std::vector<std::string> keys;
+            for (const auto& [key, entry] : cache) keys.push_back(key);
+
+            guard.unlock();
+            for (const auto& key : keys) refresh(key);
+            guard.lock();
+        }
+    });
+}
+
+void Resolver::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+void Resolver::fill_report(RunReport& report) const {
+    std::lock_guard<std::mutex> guard(lock);
+    auto& dns = report.section("dns");
+    for (const auto& [key, e] : cache) {
+        nlohmann::json addrs = nlohmann::json::array();
+        for (const auto& a : e.addrs) addrs.push_back(a.to_string());
+
+        dns[key] = {
+            {"addresses", addrs},
+            {"first_ms", e.first_ms},
+            {"last_ms", e.last_ms},
+            {"worst_ms", e.worst_ms},
+            {"lookups", e.lookups},
+            {"changes", e.changes},
+            {"failures", e.failures}
+        };
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#endif
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "report.hpp"
+
+struct ResolvedAddress {
+    sockaddr_storage addr;
+    socklen_t len;
+
+    std::string to_string() const;
+};
+
+// Plain getaddrinfo lookup, elapsed_ms receives the time it took
+std::vector<ResolvedAddress> system_resolve(const std::string& host, int port, double& elapsed_ms);
+
+// DNS cache for the handful of hosts the bot talks to. Everything is resolved at startup,
+// re-validated by a background thread while we wait, and the Linux transport connects
+// straight to the pinned addresses. WinHTTP resolves by itself, but the lookups made
+// here keep the OS resolver cache warm for it.
+class Resolver {
+private:
+    struct Entry {
+        std::string host;
+        int port = 443;
+        std::vector<ResolvedAddress> addrs;
+        double first_ms = 0;    // Initial resolution time
+        double last_ms = 0;     // Most recent re-validation time
+        double worst_ms = 0;
+        int lookups = 0;
+        int changes = 0;        // Re-validations that returned a different address set
+        int failures = 0;
+    };
+
+    std::map<std::string, Entry> cache; // Keyed by host:port
+    mutable std::mutex lock;
+    std::thread worker;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    bool refresh(const std::string& key);
+
+public:
+    Resolver();
+    ~Resolver();
+
+    // Resolves now (blocking) and pins the result, false if the lookup failed
+    bool resolve(const std::string& host, int port = 443);
+
+    // Pinned addresses for host:port; resolves on a cache miss
+    std::vector<ResolvedAddress> lookup(const std::string& host, int port = 443);
+
+    // Re-validates every cached host each interval_ms until stop_refresh()
+    void start_refresh(int interval_ms);
+    void stop_refresh();
+
+    void fill_report(RunReport& report) const;
+};
@@ -0,0 +1,132 @@
+#include "seal.hpp"
+#include <algorithm>
+#ifdef _WIN32
+#include <windows.h>
+#include <wincrypt.h>
+#else
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#endif
+
+// --- INTERNAL HELPERS ---
+
+static const std::string MAGIC = "ITUSEAL1";
+
+#ifndef _WIN32
+static const int SALT_LEN = 16;
+static const int IV_LEN = 12;
+static const int TAG_LEN = 16;
+static const int KEY_LEN = 32;
+static const int KDF_ROUNDS = 200000;
+
+static bool derive_key(const std::string& passphrase, const unsigned char* salt, unsigned char* key) {
+    return PKCS5_PBKDF2_HMAC(passphrase.data(), (int)passphrase.size(), salt, SALT_LEN, KDF_ROUNDS,
+                             EVP_sha256(), KEY_LEN, key) == 1;
+}
+#endif
+
+// --- SEALING ---
+
+bool is_sealed(const std::string& data) {
+    return data.compare(0, MAGIC.size(), MAGIC) == 0;
+}
+
+#ifdef _WIN32
+
+bool seal_secret(const std::string& plain, const std::string& passphrase, std::string& sealed, std::string& error) {
+    DATA_BLOB in{(DWORD)plain.size(), (BYTE*)plain.data()};
+    DATA_BLOB entropy{(DWORD)passphrase.size(), (BYTE*)passphrase.data()};
+    DATA_BLOB out{};
+    if (!CryptProtectData(&in, L"itu-bot", &entropy, nullptr, nullptr, CRYPTPROTECT_UI_FORBIDDEN, &out)) {
+        error = "CryptProtectData failed (error " + std::to_string(GetLastError()) + ")";
+        return false;
+    }
+    sealed = MAGIC + std::string((const char*)out.pbData, out.cbData);
+    LocalFree(out.pbData);
+    return true;
+}
+
+bool unseal_secret(const std::string& sealed, const std::string& passphrase, std::string& plain, std::string& error) {
+    if (!is_sealed(sealed)) {
+        error = "not a sealed file";
+        return false;
+    }
+    DATA_BLOB in{(DWORD)(sealed.size() - MAGIC.size()), (BYTE*)sealed.data() + MAGIC.size()};
+    DATA_BLOB entropy{(DWORD)passphrase.size(), (BYTE*)passphrase.data()};
+    DATA_BLOB out{};
+    if (!CryptUnprotectData(&in, nullptr, &entropy, nullptr, nullptr, CRYPTPROTECT_UI_FORBIDDEN, &out)) {
+        error = "CryptUnprotectData failed (other user, or the password changed)";
+        return false;
+    }
+    plain.assign((const char*)out.pbData, out.cbData);
+    SecureZeroMemory(out.pbData, out.cbData);
+    LocalFree(out.pbData);
+    return true;
+}
+
+#else
+
+// Layout: magic | salt | iv | tag | ciphertext
+bool seal_secret(const std::string& plain, const std::string& passphrase, std::string& sealed, std::string& error) {
+    unsigned char salt[SALT_LEN], iv[IV_LEN], tag[TAG_LEN], key[KEY_LEN];
+    if (RAND_bytes(salt, SALT_LEN) != 1 || RAND_bytes(iv, IV_LEN) != 1 || !derive_key(passphrase, salt, key)) {
+        error = "key setup failed";
+        return false;
+    }
+
+    std::string cipher(plain.size(), '\0');
+    int len = 0, tail = 0;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx && EVP_EncryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, iv) == 1 &&
+              EVP_EncryptUpdate(ctx, (unsigned char*)&cipher[0], &len, (const unsigned char*)plain.data(), (int)plain.size()) == 1 &&
+              EVP_EncryptFinal_ex(ctx, (unsigned char*)&cipher[0] + len, &tail) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_GET_TAG, TAG_LEN, tag) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(key, KEY_LEN);
+    if (!ok) {
+        error = "AES-GCM encryption failed";
+        return false;
+    }
+
+    cipher.resize(len + tail);
+    sealed = MAGIC;
+    sealed.append((const char*)salt, SALT_LEN).append((const char*)iv, IV_LEN).append((const char*)tag, TAG_LEN);
+    sealed += cipher;
+    return true;
+}
+
+bool unseal_secret(const std::string& sealed, const std::string& passphrase, std::string& plain, std::string& error) {
+    const size_t header = MAGIC.size() + SALT_LEN + IV_LEN + TAG_LEN;
+    if (!is_sealed(sealed) || sealed.size() < header) {
+        error = "not a sealed file";
+        return false;
+    }
+    const unsigned char* salt = (const unsigned char*)sealed.data() + MAGIC.size();
+    const unsigned char* iv = salt + SALT_LEN;
+    unsigned char tag[TAG_LEN], key[KEY_LEN];
+    std::copy(iv + IV_LEN, iv + IV_LEN + TAG_LEN, tag);
+    if (!derive_key(passphrase, salt, key)) {
+        error = "key setup failed";
+        return false;
+    }
+
+    std::string out(sealed.size() - header, '\0');
+    int len = 0, tail = 0;
+    EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
+    bool ok = ctx && EVP_DecryptInit_ex(ctx, EVP_aes_256_gcm(), nullptr, key, iv) == 1 &&
+              EVP_DecryptUpdate(ctx, (unsigned char*)&out[0], &len, (const unsigned char*)sealed.data() + header, (int)out.size()) == 1 &&
+              EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, TAG_LEN, tag) == 1 &&
+              EVP_DecryptFinal_ex(ctx, (unsigned char*)&out[0] + len, &tail) == 1;
+    EVP_CIPHER_CTX_free(ctx);
+    OPENSSL_cleanse(key, KEY_LEN);
+    if (!ok) {
+        // The tag check fails for a wrong passphrase as well as for a damaged file
+        error = "cannot decrypt (password changed or file damaged)";
+        return false;
+    }
+    out.resize(len + tail);
+    plain = std::move(out);
+    return true;
+}
+
+#endif
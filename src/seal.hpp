@@ -0,0 +1,11 @@
+#pragma once
+#include <string>
+
+// Encryption for the small secrets the bot keeps on disk (the saved session). On Windows they are
+// bound to the user account with DPAPI, the passphrase goes in as extra entropy. Elsewhere they
+// are AES-256-GCM encrypted with a key derived from the passphrase (PBKDF2-SHA256, random salt).
+// Sealed data starts with a magic tag, so readers can tell it from a plain file.
+bool seal_secret(const std::string& plain, const std::string& passphrase, std::string& sealed, std::string& error);
+bool unseal_secret(const std::string& sealed, const std::string& passphrase, std::string& plain, std::string& error);
+
+bool is_sealed(const std::string& data);
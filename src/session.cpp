@@ -0,0 +1,130 @@
+#include "session.hpp"
+#include "seal.hpp"
+#include "../include/nlohmann_json.hpp"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#ifndef _WIN32
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+// --- INTERNAL HELPERS ---
+
+static const int SNAPSHOT_VERSION = 1;
+
+static json cookie_to_json(const Cookie& c) {
+    return json{{"name", c.name}, {"value", c.value}, {"domain", c.domain}, {"path", c.path},
+                {"host_only", c.host_only}, {"secure", c.secure}, {"expires", (long long)c.expires}};
+}
+
+static Cookie cookie_from_json(const json& j) {
+    Cookie c;
+    c.name = j.value("name", "");
+    c.value = j.value("value", "");
+    c.domain = j.value("domain", "");
+    c.path = j.value("path", "/");
+    c.host_only = j.value("host_only", true);
+    c.secure = j.value("secure", false);
+    c.expires = (std::time_t)j.value("expires", 0LL);
+    return c;
+}
+
+// --- SNAPSHOT FILE ---
+
+bool save_session(const std::string& path, const SessionSnapshot& s, const std::string& passphrase,
+                  bool encrypt, std::string& error) {
+    json cookies = json::array();
+    for (const Cookie& c : s.cookies) cookies.push_back(cookie_to_json(c));
+
+    std::string data = json{{"version", SNAPSHOT_VERSION}, {"user", s.user}, {"token", s.token},
+                            {"acquired", s.acquired_s}, {"exp", s.expires_s}, {"saved", s.saved_s},
+                            {"landed_url", s.landed_url}, {"sub_session_id", s.sub_session_id},
+                            {"cookies", cookies}}.dump();
+    if (encrypt) {
+        std::string sealed;
+        if (!seal_secret(data, passphrase, sealed, error)) return false;
+        data = std::move(sealed);
+    }
+
+    std::string temp = path + ".tmp";
+#ifndef _WIN32
+    // Owner-only from the moment it exists: the snapshot holds the cookies and the JWT, in plain
+    // text when encryption is off. fchmod covers a stale temp file left with other permissions
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOFOLLOW, 0600);
+    if (fd < 0) {
+        error = "cannot create " + temp + ": " + std::strerror(errno);
+        return false;
+    }
+    bool written = fchmod(fd, 0600) == 0;
+    for (size_t done = 0; written && done < data.size();) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) written = false;
+        else done += (size_t)n;
+    }
+    written = written && fsync(fd) == 0;
+    if (close(fd) != 0) written = false;
+    if (!written) {
+        error = "cannot write " + temp + ": " + std::strerror(errno);
+        unlink(temp.c_str());
+        return false;
+    }
+#else
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.write(data.data(), (std::streamsize)data.size()) || !file.flush()) {
+            error = "cannot write " + temp;
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+#endif
+    if (std::rename(temp.c_str(), path.c_str()) != 0) {
+        error = "cannot replace " + path;
+        std::remove(temp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool load_session(const std::string& path, const std::string& passphrase, SessionSnapshot& out, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "no saved session";
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    if (is_sealed(data)) {
+        std::string plain;
+        if (!unseal_secret(data, passphrase, plain, error)) return false;
+        data = std::move(plain);
+    }
+
+    json j = json::parse(data, nullptr, false);
+    if (j.is_discarded() || !j.is_object() || j.value("version", 0) != SNAPSHOT_VERSION) {
+        error = "unreadable session file";
+        return false;
+    }
+
+    out = SessionSnapshot();
+    out.user = j.value("user", "");
+    out.token = j.value("token", "");
+    out.acquired_s = j.value("acquired", 0LL);
+    out.expires_s = j.value("exp", 0LL);
+    out.saved_s = j.value("saved", 0LL);
+    out.landed_url = j.value("landed_url", "");
+    out.sub_session_id = j.value("sub_session_id", "");
+    if (j.contains("cookies") && j["cookies"].is_array()) {
+        for (const json& c : j["cookies"]) {
+            if (c.is_object()) out.cookies.push_back(cookie_from_json(c));
+        }
+    }
+    return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "cookies.hpp"
+
+// Everything a restarted process needs to pick up a logged-in session without the login chain:
+// the cookie jar, where the login landed and the last JWT. Times are server seconds.
+struct SessionSnapshot {
+    std::string user;
+    std::string token;          // Raw JWT, without "Bearer "
+    long long acquired_s = 0;   // When the token was issued to us
+    long long expires_s = 0;
+    long long saved_s = 0;
+    std::string landed_url;     // Login page URL after the redirect chain
+    std::string sub_session_id; // Its subSessionId parameter
+    std::vector<Cookie> cookies;
+};
+
+// Writes the snapshot as JSON, sealed with passphrase when encrypt is set (see seal.hpp). The file
+// is replaced in one rename, a crash never leaves half of it
+bool save_session(const std::string& path, const SessionSnapshot& snapshot, const std::string& passphrase,
+                  bool encrypt, std::string& error);
+
+// Reads a snapshot written by save_session, sealed or plain
+bool load_session(const std::string& path, const std::string& passphrase, SessionSnapshot& out, std::string& error);
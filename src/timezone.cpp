@@ -0,0 +1,247 @@
+#include "timezone.hpp"
+#include "httpdate.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+// --- INTERNAL HELPERS ---
+
+struct FixedZone {
+    const char* name;
+    long long offset_s;
+};
+
+// For hosts without a tz database. Turkey has stayed on UTC+3 all year since September 2016
+static const FixedZone BUILT_IN_ZONES[] = {
+    {"UTC", 0}, {"Etc/UTC", 0}, {"GMT", 0}, {"Etc/GMT", 0},
+    {"Europe/Istanbul", 3 * 3600}, {"Asia/Istanbul", 3 * 3600}, {"Turkey", 3 * 3600},
+};
+
+static long long read_be(const std::string& data, size_t pos, int bytes) {
+    unsigned long long v = 0;
+    for (int i = 0; i < bytes; i++) v = (v << 8) | (unsigned char)data[pos + i];
+    // Sign-extend 32 bit fields
+    if (bytes == 4) return (long long)(int)(unsigned)v;
+    return (long long)v;
+}
+
+static long long days_of(int year, int month, int day) {
+    return (long long)utc_from_civil(year, month, day, 0, 0, 0) / 86400;
+}
+
+static int days_in_month(int year, int month) {
+    return (int)(days_of(month == 12 ? year + 1 : year, month == 12 ? 1 : month + 1, 1) - days_of(year, month, 1));
+}
+
+// Zone abbreviation: letters, or anything between < and >
+static bool skip_name(const std::string& s, size_t& pos) {
+    size_t start = pos;
+    if (pos < s.size() && s[pos] == '<') {
+        size_t close = s.find('>', pos);
+        if (close == std::string::npos) return false;
+        pos = close + 1;
+        return true;
+    }
+    while (pos < s.size() && ((s[pos] >= 'A' && s[pos] <= 'Z') || (s[pos] >= 'a' && s[pos] <= 'z'))) pos++;
+    return pos - start >= 3;
+}
+
+// [+-]hh[:mm[:ss]] as seconds
+static bool read_hms(const std::string& s, size_t& pos, long long& out) {
+    long long sign = 1;
+    if (pos < s.size() && (s[pos] == '+' || s[pos] == '-')) sign = s[pos++] == '-' ? -1 : 1;
+    long long total = 0;
+    for (int part = 0; part < 3; part++) {
+        if (part > 0) {
+            if (pos >= s.size() || s[pos] != ':') break;
+            pos++;
+        }
+        size_t digits = pos;
+        long long v = 0;
+        while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') v = v * 10 + (s[pos++] - '0');
+        if (pos == digits) return false;
+        total += v * (part == 0 ? 3600 : part == 1 ? 60 : 1);
+    }
+    out = sign * total;
+    return true;
+}
+
+static bool read_int(const std::string& s, size_t& pos, int& out) {
+    size_t digits = pos;
+    out = 0;
+    while (pos < s.size() && s[pos] >= '0' && s[pos] <= '9') out = out * 10 + (s[pos++] - '0');
+    return pos > digits;
+}
+
+// UTC instant of a rule change in year, local time read with offset
+static long long change_utc(int year, int month, int week, int weekday, long long time, long long offset) {
+    long long first = days_of(year, month, 1);
+    int first_wday = (int)(((first % 7) + 11) % 7); // 1970-01-01 was a Thursday
+    int day = 1 + (weekday - first_wday + 7) % 7 + (week - 1) * 7;
+    while (day > days_in_month(year, month)) day -= 7;
+    return (first + day - 1) * 86400 + time - offset;
+}
+
+// --- CLASS METHODS ---
+
+bool TimeZone::load(const std::string& name) {
+    zone = name;
+    transitions.clear();
+    offsets.clear();
+    initial_offset = 0;
+    rule = Rule();
+    error.clear();
+
+    if (name.empty() || name.find("..") != std::string::npos || name[0] == '/') {
+        error = "invalid zone name \"" + name + "\"";
+        return false;
+    }
+
+    const char* dir = std::getenv("TZDIR");
+    std::ifstream file(std::string(dir && *dir ? dir : "/usr/share/zoneinfo") + "/" + name, std::ios::binary);
+    if (file) {
+        std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (load_tzif(data)) return true;
+        error = "unreadable tz database file for " + name;
+        return false;
+    }
+
+    for (const FixedZone& z : BUILT_IN_ZONES) {
+        if (name == z.name) {
+            initial_offset = z.offset_s;
+            return true;
+        }
+    }
+    error = "unknown zone " + name + " (no tz database on this host, built in: Europe/Istanbul, UTC)";
+    return false;
+}
+
+bool TimeZone::load_tzif(const std::string& data) {
+    // Header: magic, version, 15 reserved bytes, six counts
+    auto header = [&](size_t pos, long long counts[6]) {
+        if (data.size() < pos + 44 || data.compare(pos, 4, "TZif") != 0) return false;
+        for (int i = 0; i < 6; i++) counts[i] = read_be(data, pos + 20 + i * 4, 4);
+        return true;
+    };
+    enum { IS_UT, IS_STD, LEAP, TIME, TYPE, CHAR };
+
+    long long c[6];
+    if (!header(0, c)) return false;
+    size_t pos = 44;
+    int time_size = 4;
+
+    // Version 2+ repeats the data with 64 bit times after the v1 block, that copy is the one to read
+    if (data[4] >= '2') {
+        pos += c[TIME] * 5 + c[TYPE] * 6 + c[CHAR] + c[LEAP] * 8 + c[IS_STD] + c[IS_UT];
+        if (!header(pos, c)) return false;
+        pos += 44;
+        time_size = 8;
+    }
+
+    size_t need = c[TIME] * (time_size + 1) + c[TYPE] * 6 + c[CHAR] + c[LEAP] * (time_size + 4) + c[IS_STD] + c[IS_UT];
+    if (c[TYPE] < 1 || data.size() < pos + need) return false;
+
+    size_t index_pos = pos + c[TIME] * time_size;
+    size_t type_pos = index_pos + c[TIME];
+    std::vector<long long> type_offsets;
+    for (long long i = 0; i < c[TYPE]; i++) type_offsets.push_back(read_be(data, type_pos + i * 6, 4));
+
+    for (long long i = 0; i < c[TIME]; i++) {
+        unsigned idx = (unsigned char)data[index_pos + i];
+        if (idx >= type_offsets.size()) return false;
+        transitions.push_back(read_be(data, pos + i * time_size, time_size));
+        offsets.push_back(type_offsets[idx]);
+    }
+    initial_offset = type_offsets[0];
+
+    // Footer: "\n<POSIX TZ>\n", rules every instant after the last transition
+    if (time_size == 8) {
+        size_t footer = pos + need;
+        if (footer < data.size() && data[footer] == '\n') {
+            size_t end = data.find('\n', footer + 1);
+            if (end != std::string::npos) parse_rule(data.substr(footer + 1, end - footer - 1), rule);
+        }
+    }
+    return true;
+}
+
+bool TimeZone::parse_rule(const std::string& s, Rule& out) {
+    size_t pos = 0;
+    long long std_west = 0;
+    if (!skip_name(s, pos) || !read_hms(s, pos, std_west)) return false;
+    out.std_offset = -std_west; // POSIX offsets count west of UTC
+    out.has_dst = false;
+
+    if (pos < s.size()) {
+        if (!skip_name(s, pos)) return false;
+        out.dst_offset = out.std_offset + 3600;
+        if (pos < s.size() && s[pos] != ',') {
+            long long dst_west = 0;
+            if (!read_hms(s, pos, dst_west)) return false;
+            out.dst_offset = -dst_west;
+        }
+
+        // Only the Mm.w.d form is read, zones whose footer uses Jn or n keep their last transition
+        Rule::Change* changes[] = {&out.start, &out.end};
+        for (Rule::Change* ch : changes) {
+            if (pos + 1 >= s.size() || s[pos] != ',' || s[pos + 1] != 'M') return false;
+            pos += 2;
+            if (!read_int(s, pos, ch->month) || pos >= s.size() || s[pos++] != '.' ||
+                !read_int(s, pos, ch->week) || pos >= s.size() || s[pos++] != '.' ||
+                !read_int(s, pos, ch->weekday)) return false;
+            if (ch->month < 1 || ch->month > 12 || ch->week < 1 || ch->week > 5 || ch->weekday > 6) return false;
+            ch->time = 7200;
+            if (pos < s.size() && s[pos] == '/') {
+                pos++;
+                if (!read_hms(s, pos, ch->time)) return false;
+            }
+        }
+        out.has_dst = true;
+    }
+    out.valid = pos == s.size();
+    return out.valid;
+}
+
+long long TimeZone::rule_offset(const Rule& r, long long utc_s) {
+    if (!r.has_dst) return r.std_offset;
+
+    // Year of the instant in standard time, close enough to pick the rule's changes
+    long long days = (utc_s + r.std_offset) / 86400 - ((utc_s + r.std_offset) % 86400 < 0 ? 1 : 0);
+    int year = 1970 + (int)(days / 365);
+    while (days_of(year, 1, 1) > days) year--;
+    while (days_of(year + 1, 1, 1) <= days) year++;
+
+    long long start = change_utc(year, r.start.month, r.start.week, r.start.weekday, r.start.time, r.std_offset);
+    long long end = change_utc(year, r.end.month, r.end.week, r.end.weekday, r.end.time, r.dst_offset);
+    bool dst = start < end ? (utc_s >= start && utc_s < end) : !(utc_s >= end && utc_s < start);
+    return dst ? r.dst_offset : r.std_offset;
+}
+
+long long TimeZone::offset_at(long long utc_s) const {
+    if (transitions.empty() || utc_s < transitions.front()) {
+        return (transitions.empty() && rule.valid) ? rule_offset(rule, utc_s) : initial_offset;
+    }
+    if (utc_s >= transitions.back() && rule.valid) return rule_offset(rule, utc_s);
+    size_t i = (size_t)(std::upper_bound(transitions.begin(), transitions.end(), utc_s) - transitions.begin()) - 1;
+    return offsets[i];
+}
+
+long long TimeZone::to_utc(int year, int month, int day, int hour, int minute, int second) const {
+    long long local = (long long)utc_from_civil(year, month, day, hour, minute, second);
+    // The offset depends on the instant it is asked for: guess with the offset at the wall time
+    // read as UTC, then settle on the offset in effect at the guess
+    long long first = local - offset_at(local - offset_at(local));
+    long long before = local - offset_at(first - 86400);
+    // Repeated hour: both readings are valid, the earlier one is the first occurrence
+    if (before < first && local - offset_at(before) == before) return before;
+    return first;
+}
+
+std::string TimeZone::format_offset(long long offset_s) {
+    char buf[32];
+    long long a = offset_s < 0 ? -offset_s : offset_s;
+    std::snprintf(buf, sizeof(buf), "UTC%c%02lld:%02lld", offset_s < 0 ? '-' : '+', a / 3600, (a / 60) % 60);
+    return buf;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <string>
+#include <vector>
+
+// UTC offsets of one IANA zone ("Europe/Istanbul"), read from the system tz database (TZif
+// files under $TZDIR or /usr/share/zoneinfo) including the POSIX rule for times past the last
+// listed transition. Hosts without a tz database (Windows) get a few built-in fixed zones.
+// Nothing here depends on the machine's own timezone setting.
+class TimeZone {
+private:
+    // POSIX TZ rule (footer of the TZif file), e.g. "CET-1CEST,M3.5.0,M10.5.0/3"
+    struct Rule {
+        struct Change {
+            int month = 0, week = 0, weekday = 0; // Mm.w.d: weekday of the w-th week (5 = last)
+            long long time = 7200;                // Local seconds after midnight
+        };
+
+        bool valid = false;
+        bool has_dst = false;
+        long long std_offset = 0, dst_offset = 0; // Seconds east of UTC
+        Change start, end;
+    };
+
+    std::string zone;
+    std::vector<long long> transitions; // UTC seconds
+    std::vector<long long> offsets;     // Offset in effect from each transition on
+    long long initial_offset = 0;       // Before the first transition
+    Rule rule;
+    std::string error;
+
+    bool load_tzif(const std::string& data);
+    static bool parse_rule(const std::string& text, Rule& out);
+    static long long rule_offset(const Rule& rule, long long utc_s);
+
+public:
+    // Loads the zone, false (see last_error()) if it is neither in the tz database nor built in
+    bool load(const std::string& name);
+
+    const std::string& name() const { return zone; }
+    const std::string& last_error() const { return error; }
+
+    // Seconds east of UTC in effect at a UTC instant
+    long long offset_at(long long utc_s) const;
+
+    // UTC instant of a wall clock time in this zone. A time skipped by a DST change is read with
+    // the offset before it, a repeated one resolves to its first occurrence
+    long long to_utc(int year, int month, int day, int hour, int minute, int second) const;
+
+    // "UTC+03:00"
+    static std::string format_offset(long long offset_s);
+};
+
+// The registration instant, resolved once from the config time block and its zone. Every phase
+// (resync, token, arm, fire) is scheduled relative to this one UTC value.
+struct TargetTime {
+    long long utc_ns = 0;     // Nanoseconds since the epoch, UTC
+    long long offset_s = 0;   // Zone offset at the target
+    std::string zone;
+
+    std::chrono::system_clock::time_point time_point() const {
+        return std::chrono::system_clock::time_point(
+            std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(utc_ns)));
+    }
+};
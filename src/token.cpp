@@ -1,11 +1,39 @@
 #include "token.hpp"
+#include "cookies.hpp"
+#include "form_scanner.hpp"
+#include "urlform.hpp"
+#include "report.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
+#include <iterator>
+#include <thread>
 #include <vector>
-#include <sstream>
-#include <iomanip>
 
 // --- INTERNAL HELPERS ---
 
+static const char* const STEP_NAMES[AUTH_STEPS] = {"landing", "credentials", "identity", "dashboard", "jwt"};
+
+// Messages of the login page for a wrong username or password (Turkish and English page). Only
+// a shortcut: the page may word or encode them differently, a repeated form counts as refused too
+static const char* const INVALID_CREDENTIALS[] = {
+    "Kullanıcı adı veya şifre hatalı", "Kullanıcı adı veya parola hatalı", "Kullanıcı adınız veya şifreniz hatalı",
+    "Invalid username or password", "Incorrect username or password", "username or password is incorrect",
+};
+
+// Nearest-rank percentile of the step latencies
+static double percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    size_t k = (size_t)std::llround(p / 100.0 * (double)(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+// Upper bounds of the latency histogram buckets, one more bucket takes everything slower
+static const int HISTOGRAM_MS[] = {25, 50, 100, 200, 400, 800, 1600, 3200, 6400};
+
 // Decodes &amp; to & so the URL parameters are valid
 std::string decode_html(std::string str) {
     size_t pos;
@@ -14,168 +42,358 @@ std::string decode_html(std::string str) {
 }
 
 // Separates https://domain.com/path into "domain.com" and "/path"
-void parse_components(const std::wstring& url, std::wstring& host, std::wstring& path) {
-    size_t start = url.find(L"://");
-    if (start == std::wstring::npos) return;
+void parse_components(const std::string& url, std::string& host, std::string& path) {
+    size_t start = url.find("://");
+    if (start == std::string::npos) return;
     start += 3;
-    size_t end = url.find(L"/", start);
-    if (end == std::wstring::npos) {
+    size_t end = url.find("/", start);
+    if (end == std::string::npos) {
         host = url.substr(start);
-        path = L"/";
+        path = "/";
     } else {
         host = url.substr(start, end - start);
         path = url.substr(end);
     }
 }
 
+static AuthResult failure(AuthStep step, AuthError error, const std::string& detail = "", int status = 0) {
+    AuthResult r;
+    r.step = step;
+    r.error = error;
+    r.detail = detail;
+    r.status = status;
+    return r;
+}
+
+// Typed error of an exchange that did not get a response
+static AuthResult exchange_failed(AuthStep step, const HttpRequest* request) {
+    if (!request) return failure(step, AuthError::Transport, "request could not be opened");
+    return failure(step, request->timed_out() ? AuthError::Timeout : AuthError::Transport, request->last_error());
+}
+
+// --- AUTH RESULT ---
+
+const char* auth_step_name(AuthStep step) {
+    return STEP_NAMES[(int)step];
+}
+
+const char* auth_error_name(AuthError error) {
+    switch (error) {
+        case AuthError::None:      return "ok";
+        case AuthError::Connect:   return "cannot connect";
+        case AuthError::Timeout:   return "timeout";
+        case AuthError::Transport: return "connection failed";
+        case AuthError::Status:    return "error status";
+        case AuthError::NoForm:    return "no login form";
+        case AuthError::Rejected:  return "credentials rejected";
+        case AuthError::NoSession: return "no session";
+        case AuthError::BadToken:  return "bad token";
+    }
+    return "unknown";
+}
+
+bool AuthResult::transient() const {
+    switch (error) {
+        case AuthError::Connect:
+        case AuthError::Timeout:
+        case AuthError::Transport:
+        case AuthError::NoForm:
+            return true;
+        case AuthError::Status:
+            return status >= 500 || status == 429 || status == 408;
+        default:
+            return false;
+    }
+}
+
+std::string AuthResult::describe() const {
+    std::string text = std::string(auth_step_name(step)) + ": " + auth_error_name(error);
+    if (status > 0 && error == AuthError::Status) text += " " + std::to_string(status);
+    if (!detail.empty()) text += " (" + detail + ")";
+    return text;
+}
+
 // --- CLASS METHODS ---
 
-TokenFetcher::TokenFetcher() {
-    hSession = WinHttpOpen(L"Mozilla/5.0 (Windows NT 10.0; Win64; x64) Chrome/144.0.0.0", 
-                            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY, NULL, NULL, 0);
-    hConnect = WinHttpConnect(hSession, L"obs.itu.edu.tr", INTERNET_DEFAULT_HTTPS_PORT, 0);
+TokenFetcher::TokenFetcher(ConnectionPool& pool, const AuthOptions& options)
+    : pool(pool), options(options), jitter(std::random_device{}()) {}
+
+std::unique_ptr<HttpRequest> TokenFetcher::open(AuthStep step, HttpConnection& conn, const std::string& method,
+                                                const std::string& path, const std::string& referer) {
+    auto request = conn.open(method, path, referer);
+    if (request) request->set_timeout(options.timeout_ms[(int)step]);
+    return request;
 }
 
-TokenFetcher::~TokenFetcher() {
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
+AuthResult TokenFetcher::perform_request(AuthStep step, HttpConnection& conn, const std::string& method, const std::string& path,
+                                         std::string_view& body_out, const std::string& body, const std::string& headers,
+                                         const std::string& referer) {
+    body_out = {};
+    auto request = open(step, conn, method, path, referer);
+    if (!request || !request->send(headers, body) || !request->receive()) return exchange_failed(step, request.get());
+
+    int status = request->status_code();
+    body_out = request->read_body(page);
+    if (status >= 400) return failure(step, AuthError::Status, request->url(), status);
+
+    AuthResult ok;
+    ok.step = step;
+    ok.status = status;
+    return ok;
 }
 
-std::string TokenFetcher::url_encode(const std::string& value) {
-    std::ostringstream escaped;
-    escaped.fill('0');
-    escaped << std::hex;
-    for (char c : value) {
-        if (isalnum((unsigned char)c) || c == '-' || c == '_' || c == '.' || c == '~') {
-            escaped << c;
-        } else {
-            escaped << '%' << std::uppercase << (int)(unsigned char)c;
+AuthResult TokenFetcher::login(const std::string& username, const std::string& password, const bool _debug = false) {
+    LoginState state(username, password, _debug);
+    int retries[AUTH_STEPS] = {};
+    AuthStep step = AuthStep::Landing;
+
+    while (true) {
+        AuthResult result = run_step(step, state);
+        if (result.ok()) {
+            if (step == AuthStep::Jwt) return result;
+            step = state.next;
+            continue;
         }
+
+        int& used = retries[(int)step];
+        if (!result.transient() || used >= options.retries) return result;
+        used++;
+        stats[(int)step].retries++;
+
+        // Equal jitter: half the backoff is fixed, the rest random, so retries of many clients
+        // hitting the same overloaded server spread out
+        int backoff = options.backoff_ms << std::min(used - 1, 10);
+        int pause = backoff / 2 + std::uniform_int_distribution<int>(0, backoff - backoff / 2)(jitter);
+        std::cout << "[Auth] " << result.describe() << ", retry " << used << "/" << options.retries
+                  << " in " << pause << "ms." << std::endl;
+        std::this_thread::sleep_for(std::chrono::milliseconds(pause));
+
+        // A credential POST is never sent twice with the same form, the next attempt starts from a
+        // fresh login page (or finds the session logged in if the POST did go through)
+        if (step == AuthStep::Credentials || step == AuthStep::Identity) step = AuthStep::Landing;
     }
-    return escaped.str();
 }
 
-std::string TokenFetcher::extract_value(const std::string& html, const std::string& name) {
-    std::string search_str = "id=\"" + name + "\" value=\"";
-    size_t start = html.find(search_str);
-    if (start == std::string::npos) return "";
-    start += search_str.length();
-    size_t end = html.find("\"", start);
-    return html.substr(start, end - start);
+AuthResult TokenFetcher::run_step(AuthStep step, LoginState& state) {
+    double started = SystemClock::local_ms();
+    AuthResult result;
+    switch (step) {
+        case AuthStep::Landing:     result = step_landing(state); break;
+        case AuthStep::Credentials: result = step_credentials(state); break;
+        case AuthStep::Identity:    result = step_identity(state); break;
+        case AuthStep::Dashboard:   result = step_dashboard(state); break;
+        case AuthStep::Jwt:         result = fetch_jwt(**state.obs, !state.debug); break;
+    }
+    double ms = SystemClock::local_ms() - started;
+    record(step, ms, result);
+    if (state.debug) std::cout << "[Debug] " << auth_step_name(step) << " took " << (long long)ms << "ms" << std::endl;
+    return result;
 }
 
-std::string TokenFetcher::get_bearer_token(const std::string& username, const std::string& password, const bool _debug = false) {
+AuthResult TokenFetcher::step_landing(LoginState& state) {
     std::cout << "[Auth] Step 1: Initializing handshake with obs.itu.edu.tr..." << std::endl;
 
+    if (!state.obs) state.obs.emplace(pool.acquire("obs.itu.edu.tr"));
+    if (!*state.obs) {
+        state.obs.reset();
+        return failure(AuthStep::Landing, AuthError::Connect, "obs.itu.edu.tr");
+    }
+
     // GET Root to trigger redirect chain
-    HINTERNET hReq1 = WinHttpOpenRequest(hConnect, L"GET", L"/", NULL, NULL, NULL, WINHTTP_FLAG_SECURE);
-    WinHttpSendRequest(hReq1, WINHTTP_NO_ADDITIONAL_HEADERS, 0, NULL, 0, 0, 0);
-    WinHttpReceiveResponse(hReq1, NULL);
+    auto req1 = open(AuthStep::Landing, **state.obs, "GET", "/");
+    if (!req1 || !req1->send() || !req1->receive()) return exchange_failed(AuthStep::Landing, req1.get());
+    int status = req1->status_code();
+    std::string url = req1->url();
+    if (status >= 400) return failure(AuthStep::Landing, AuthError::Status, url, status);
 
     // DEBUG: Print the final login URL with subSessionId
-    wchar_t landed_url[2048]; 
-    DWORD url_len = sizeof(landed_url); 
-    WinHttpQueryOption(hReq1, WINHTTP_OPTION_URL, landed_url, &url_len); 
-    if(_debug) std::wcout << L"[Debug] Final Login URL: " << landed_url << std::endl;
-
-    std::wstring auth_host, auth_path;
-    parse_components(landed_url, auth_host, auth_path);
-
-    // Read HTML to get ASP tokens
-    std::string html;
-    DWORD dwSize = 0;
-    while (WinHttpQueryDataAvailable(hReq1, &dwSize) && dwSize > 0) {
-        std::vector<char> buffer(dwSize);
-        DWORD dwDownloaded = 0;
-        WinHttpReadData(hReq1, (LPVOID)&buffer[0], dwSize, &dwDownloaded);
-        html.append(buffer.data(), dwDownloaded);
+    if(state.debug) std::cout << "[Debug] Final Login URL: " << url << std::endl;
+
+    std::string auth_path;
+    state.auth_host.clear();
+    parse_components(url, state.auth_host, auth_path);
+
+    // Scrape ASP tokens and Form Action while the page downloads, reading stops once they are all
+    // in (they sit at the top of the form)
+    FormScanner form({"__VIEWSTATE", "__VIEWSTATEGENERATOR", "__EVENTVALIDATION"});
+    std::string_view html = req1->read_body_until(page, [&form](std::string_view body) { return form.scan(body); });
+    if(state.debug) std::cout << "[Debug] Login form fields found in the first " << html.size() << " bytes of the page" << std::endl;
+
+    // On HTTP/2 this cancels the rest of the page and the POST below reuses the socket right away.
+    // An HTTP/1.1 socket is drained first, which is still cheaper than a new handshake
+    req1.reset();
+
+    if (form.value(html, 0).empty()) {
+        // A session the server already accepted (a retried POST that did go through) stays on obs
+        if (state.auth_host == (*state.obs)->host() && has_session()) {
+            if(state.debug) std::cout << "[Debug] Session is already logged in, skipping the form." << std::endl;
+            state.next = AuthStep::Dashboard;
+            AuthResult ok;
+            ok.step = AuthStep::Landing;
+            ok.status = status;
+            return ok;
+        }
+        return failure(AuthStep::Landing, AuthError::NoForm, url);
+    }
+
+    landed_url = url;
+    sub_session_id.clear();
+    size_t sub = landed_url.find("subSessionId=");
+    if (sub != std::string::npos) {
+        sub += 13;
+        sub_session_id = landed_url.substr(sub, landed_url.find('&', sub) - sub);
     }
-    WinHttpCloseHandle(hReq1);
-
-    // Scrape tokens and Form Action
-    std::string vs = extract_value(html, "__VIEWSTATE");
-    std::string vsg = extract_value(html, "__VIEWSTATEGENERATOR");
-    std::string ev = extract_value(html, "__EVENTVALIDATION");
-    
-    std::string action_url = "/Login.aspx";
-    size_t a_start = html.find("action=\"");
-    if (a_start != std::string::npos) {
-        size_t a_end = html.find("\"", a_start + 8);
-        std::string raw = html.substr(a_start + 8, a_end - (a_start + 8));
+
+    state.action_url = "/Login.aspx";
+    if (form.has_action()) {
+        std::string raw(form.action(html));
         if (raw.find("./") == 0) raw = "/" + raw.substr(2);
-        action_url = decode_html(raw);
+        state.action_url = decode_html(raw);
     }
 
+    // Encoded straight out of the page, so nothing of it has to outlive this step
+    state.form_body.clear();
+    append_form_field(state.form_body, "__VIEWSTATE", form.value(html, 0));
+    append_form_field(state.form_body, "__VIEWSTATEGENERATOR", form.value(html, 1));
+    append_form_field(state.form_body, "__EVENTVALIDATION", form.value(html, 2));
+    append_form_field(state.form_body, "ctl00$ContentPlaceHolder1$tbUserName", state.username);
+    append_form_field(state.form_body, "ctl00$ContentPlaceHolder1$tbPassword", state.password);
+    append_form_field(state.form_body, "ctl00$ContentPlaceHolder1$btnLogin", "Giriş / Login");
+
+    state.next = AuthStep::Credentials;
+    AuthResult ok;
+    ok.step = AuthStep::Landing;
+    ok.status = status;
+    return ok;
+}
+
+AuthResult TokenFetcher::step_credentials(LoginState& state) {
     // POST Credentials to the AUTH server (girisv3)
-    std::cout << "[Auth] Step 2: Submitting credentials to " << std::string(auth_host.begin(), auth_host.end()) << "..." << std::endl;
-    std::string post_data = "__VIEWSTATE=" + url_encode(vs) +
-        "&__VIEWSTATEGENERATOR=" + url_encode(vsg) +
-        "&__EVENTVALIDATION=" + url_encode(ev) +
-        "&ctl00$ContentPlaceHolder1$tbUserName=" + url_encode(username) +
-        "&ctl00$ContentPlaceHolder1$tbPassword=" + url_encode(password) +
-        "&ctl00$ContentPlaceHolder1$btnLogin=" + url_encode("Giriş / Login");
-
-    HINTERNET hAuthConn = WinHttpConnect(hSession, auth_host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-    std::wstring wAction(action_url.begin(), action_url.end());
-    HINTERNET hReq2 = WinHttpOpenRequest(hAuthConn, L"POST", wAction.c_str(), NULL, landed_url, NULL, WINHTTP_FLAG_SECURE);
-    
-    std::wstring post_h = L"Content-Type: application/x-www-form-urlencoded\r\n";
-    WinHttpSendRequest(hReq2, post_h.c_str(), -1L, (LPVOID)post_data.c_str(), post_data.length(), post_data.length(), 0);
-    WinHttpReceiveResponse(hReq2, NULL);
-
-    std::string login_res;
-    while (WinHttpQueryDataAvailable(hReq2, &dwSize) && dwSize > 0) {
-        std::vector<char> buf(dwSize);
-        DWORD dwDownloaded = 0;
-        WinHttpReadData(hReq2, (LPVOID)&buf[0], dwSize, &dwDownloaded);
-        login_res.append(buf.data(), dwDownloaded);
+    std::cout << "[Auth] Step 2: Submitting credentials to " << state.auth_host << "..." << std::endl;
+
+    if (state.auth && (*state.auth)->host() != state.auth_host) state.auth.reset();
+    if (!state.auth) state.auth.emplace(pool.acquire(state.auth_host));
+    if (!*state.auth) {
+        state.auth.reset();
+        return failure(AuthStep::Credentials, AuthError::Connect, state.auth_host);
     }
-    WinHttpCloseHandle(hReq2);
 
-    /** TODO: Reconsider this part */
+    std::string post_h = "Content-Type: application/x-www-form-urlencoded\r\n";
+    std::string_view login_res;
+    AuthResult result = perform_request(AuthStep::Credentials, **state.auth, "POST", state.action_url, login_res,
+                                        state.form_body, post_h, landed_url);
+    if (!result.ok()) return result;
+
     // Handle Identity Selection if page appears
-    // if (login_res.find("SelectIdentity") != std::string::npos) {
-    //     std::cout << "[Auth] Step 3: Selecting Student Identity..." << std::endl;
-    //     size_t id_pos = login_res.find("href=\"/Login.aspx?identityGuid=");
-    //     if (id_pos != std::string::npos) {
-    //         std::string id_path = decode_html(login_res.substr(id_pos + 6, login_res.find("\"", id_pos + 6) - (id_pos + 6)));
-    //         std::wstring wIdPath(id_path.begin(), id_path.end());
-    //         HINTERNET hReq3 = WinHttpOpenRequest(hAuthConn, L"GET", wIdPath.c_str(), NULL, NULL, NULL, WINHTTP_FLAG_SECURE);
-    //         WinHttpSendRequest(hReq3, WINHTTP_NO_ADDITIONAL_HEADERS, 0, NULL, 0, 0, 0);
-    //         WinHttpReceiveResponse(hReq3, NULL);
-    //         WinHttpCloseHandle(hReq3);
-    //     }
-    // }
-    WinHttpCloseHandle(hAuthConn);
+    if (login_res.find("SelectIdentity") != std::string::npos) {
+        size_t id_pos = login_res.find("href=\"/Login.aspx?identityGuid=");
+        if (id_pos == std::string::npos) return failure(AuthStep::Credentials, AuthError::NoForm, "identity selection without an identity link");
+        state.identity_path = decode_html(std::string(login_res.substr(id_pos + 6, login_res.find('"', id_pos + 6) - (id_pos + 6))));
+        state.next = AuthStep::Identity;
+    } else if (login_res.find("tbPassword") != std::string::npos) {
+        // The login form came back instead of a redirect to obs. A bare form once may be an expired
+        // ViewState or an overloaded backend and gets one retry from a fresh landing page. Twice in
+        // a row is taken as refused credentials, further attempts could lock the account
+        for (const char* marker : INVALID_CREDENTIALS) {
+            if (login_res.find(marker) != std::string::npos) return failure(AuthStep::Credentials, AuthError::Rejected, marker);
+        }
+        if (++state.reforms > 1) return failure(AuthStep::Credentials, AuthError::Rejected, "login form shown again after a retry");
+        return failure(AuthStep::Credentials, AuthError::NoForm, "login form shown again");
+    } else {
+        state.next = AuthStep::Dashboard;
+    }
+    return result;
+}
 
+AuthResult TokenFetcher::step_identity(LoginState& state) {
+    std::cout << "[Auth] Selecting the student identity..." << std::endl;
+    std::string_view res;
+    AuthResult result = perform_request(AuthStep::Identity, **state.auth, "GET", state.identity_path, res);
+    state.next = AuthStep::Dashboard;
+    return result;
+}
+
+AuthResult TokenFetcher::step_dashboard(LoginState& state) {
     // Land on Student Dashboard and Fetch JWT
     std::cout << "[Auth] Step 3: Finalizing context and fetching JWT..." << std::endl;
-    
+
     // Visit /ogrenci/
-    HINTERNET hReq4 = WinHttpOpenRequest(hConnect, L"GET", L"/ogrenci/", NULL, NULL, NULL, WINHTTP_FLAG_SECURE);
-    WinHttpSendRequest(hReq4, WINHTTP_NO_ADDITIONAL_HEADERS, 0, NULL, 0, 0, 0);
-    WinHttpReceiveResponse(hReq4, NULL);
-    WinHttpCloseHandle(hReq4);
-
-    // Fetch JWT
-    HINTERNET hReq5 = WinHttpOpenRequest(hConnect, L"GET", L"/ogrenci/auth/jwt", NULL, NULL, NULL, WINHTTP_FLAG_SECURE);
-    std::wstring jwt_h = L"X-Requested-With: XMLHttpRequest\r\nAccept: application/json, text/plain, */*\r\n";
-    WinHttpSendRequest(hReq5, jwt_h.c_str(), -1L, NULL, 0, 0, 0);
-    WinHttpReceiveResponse(hReq5, NULL);
-
-    std::string jwt;
-    while (WinHttpQueryDataAvailable(hReq5, &dwSize) && dwSize > 0) {
-        std::vector<char> buf(dwSize);
-        DWORD dwDown = 0;
-        WinHttpReadData(hReq5, (LPVOID)&buf[0], dwSize, &dwDown);
-        jwt.append(buf.data(), dwDown);
-    }
-    WinHttpCloseHandle(hReq5);
+    std::string_view res;
+    AuthResult result = perform_request(AuthStep::Dashboard, **state.obs, "GET", "/ogrenci/", res);
+    state.next = AuthStep::Jwt;
+    return result;
+}
+
+AuthResult TokenFetcher::fetch_jwt(HttpConnection& obs, bool quiet) {
+    std::string jwt_h = "X-Requested-With: XMLHttpRequest\r\nAccept: application/json, text/plain, */*\r\n";
+    std::string_view jwt;
+    AuthResult result = perform_request(AuthStep::Jwt, obs, "GET", "/ogrenci/auth/jwt", jwt, "", jwt_h);
+    if (!result.ok()) return result;
 
-    if (jwt.find("<!DOCTYPE") != std::string::npos || jwt.length() < 20) {
-        std::cout << "[Debug] JWT response body: " << jwt.substr(0, 100) << "..." << std::endl;
-        return "ERROR: Login failed. Body is HTML.";
+    bool html = jwt.find("<!DOCTYPE") != std::string::npos;
+    if (html || jwt.length() < 20) {
+        if (!quiet) std::cout << "[Debug] JWT response body: " << jwt.substr(0, 100) << "..." << std::endl;
+        // The login page instead of a token: the server does not know the session
+        if (html) return failure(AuthStep::Jwt, AuthError::NoSession, "login page instead of a token");
+        return failure(AuthStep::Jwt, AuthError::BadToken, std::to_string(jwt.length()) + " byte answer");
     }
 
-    return "Bearer " + jwt;
-}
\ No newline at end of file
+    result.bearer = "Bearer " + std::string(jwt);
+    return result;
+}
+
+AuthResult TokenFetcher::renew_token(const bool _debug) {
+    if (!has_session()) return failure(AuthStep::Jwt, AuthError::NoSession, "nothing to renew");
+    if(_debug) std::cout << "[Debug] Renewing JWT on session " << (sub_session_id.empty() ? landed_url : sub_session_id) << std::endl;
+
+    auto obs = pool.acquire("obs.itu.edu.tr");
+    if (!obs) return failure(AuthStep::Jwt, AuthError::Connect, "obs.itu.edu.tr");
+
+    // An expired session answers with the login page instead of a token
+    double started = SystemClock::local_ms();
+    AuthResult result = fetch_jwt(*obs, !_debug);
+    record(AuthStep::Jwt, SystemClock::local_ms() - started, result);
+    return result;
+}
+
+void TokenFetcher::record(AuthStep step, double ms, const AuthResult& result) {
+    StepStats& s = stats[(int)step];
+    s.runs++;
+    s.ms.push_back(ms);
+    if (!result.ok()) s.failures++;
+    if (result.error == AuthError::Timeout) s.timeouts++;
+}
+
+void TokenFetcher::forget_session() {
+    landed_url.clear();
+    sub_session_id.clear();
+    if (CookieJar* jar = cookies()) jar->clear();
+}
+
+void TokenFetcher::fill_report(RunReport& report) const {
+    auto& login = report.section("login");
+    login["bucket_ms"] = HISTOGRAM_MS;
+    for (int i = 0; i < AUTH_STEPS; i++) {
+        const StepStats& s = stats[i];
+        if (s.runs == 0) continue;
+
+        // Counts per bucket of bucket_ms, the last one is everything slower
+        std::vector<int> histogram(std::size(HISTOGRAM_MS) + 1, 0);
+        for (double ms : s.ms) {
+            size_t b = 0;
+            while (b < std::size(HISTOGRAM_MS) && ms > HISTOGRAM_MS[b]) b++;
+            histogram[b]++;
+        }
+        login[STEP_NAMES[i]] = {
+            {"runs", s.runs},
+            {"failures", s.failures},
+            {"timeouts", s.timeouts},
+            {"retries", s.retries},
+            {"timeout_ms", options.timeout_ms[i]},
+            {"p50_ms", percentile(s.ms, 50)},
+            {"p90_ms", percentile(s.ms, 90)},
+            {"max_ms", percentile(s.ms, 100)},
+            {"histogram", histogram}
+        };
+    }
+}
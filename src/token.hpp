@@ -1,25 +1,142 @@
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
-#include <windows.h>
-#include <winhttp.h>
+#include <optional>
+#include <random>
 #include <string>
+#include <string_view>
+#include <vector>
+#include "transport.hpp"
+#include "pool.hpp"
+#include "memory.hpp"
+
+class RunReport;
+
+// Steps of the login chain, in the order they run. Identity only runs when the credential
+// POST answers with the identity selection page
+enum class AuthStep { Landing, Credentials, Identity, Dashboard, Jwt };
+const int AUTH_STEPS = 5;
+
+// Why a step failed
+enum class AuthError {
+    None,
+    Connect,   // No connection to the host could be set up
+    Timeout,   // A send or receive made no progress within the step's timeout
+    Transport, // The connection broke or TLS failed
+    Status,    // The server answered with an error status
+    NoForm,    // The login page came without its form fields
+    Rejected,  // The credentials were refused
+    NoSession, // Nothing to renew, or the server does not know the session (any more)
+    BadToken,  // The JWT endpoint answered with something that is not a token
+};
+
+// "landing", "credentials", ..., also the config and report keys
+const char* auth_step_name(AuthStep step);
+const char* auth_error_name(AuthError error);
+
+// Outcome of a login or a renewal
+struct AuthResult {
+    AuthError error = AuthError::None;
+    AuthStep step = AuthStep::Landing; // Last step run, the failed one on error
+    int status = 0;                    // HTTP status of that step, 0 if none came
+    std::string bearer;                // "Bearer <jwt>" on success
+    std::string detail;                // Transport error, or what came instead of the expected page
+
+    bool ok() const { return error == AuthError::None; }
+    // Worth another attempt: timeouts, broken connections, overload answers (5xx, 429, 408) and
+    // a login page without its form, which is what the server sends under peak load, or the login
+    // form once more after the credentials were posted
+    bool transient() const;
+    // "credentials: timeout (Operation timed out.)"
+    std::string describe() const;
+};
+
+// Knobs from the "auth" config block
+struct AuthOptions {
+    int timeout_ms[AUTH_STEPS] = {10000, 15000, 10000, 10000, 5000}; // Per step, indexed by AuthStep
+    int retries = 2;                                                // Extra attempts of a step after a transient failure
+    int backoff_ms = 250;                                           // Pause before the first retry, doubled for each one after
+};
 
 class TokenFetcher {
 private:
-    HINTERNET hSession;
-    HINTERNET hConnect;
+    ConnectionPool& pool;
+    ResponseBuffer page; // Every response of the login chain is read into this one arena
+    AuthOptions options;
+    std::mt19937 jitter;
+
+    // Where the last login (or the restored session) landed, kept for the session snapshot
+    std::string landed_url;
+    std::string sub_session_id;
 
-    std::string perform_request(const std::wstring& method, const std::wstring& path, 
-                               const std::string& body = "", const std::wstring& headers = L"");
+    // Latency of every attempt of a step, failed ones included
+    struct StepStats {
+        int runs = 0;
+        int failures = 0;
+        int timeouts = 0;
+        int retries = 0;
+        std::vector<double> ms;
+    };
+    StepStats stats[AUTH_STEPS];
 
-    std::string extract_value(const std::string& html, const std::string& name);
-    std::string url_encode(const std::string& value);
+    // What one login carries from step to step
+    struct LoginState {
+        const std::string& username;
+        const std::string& password;
+        bool debug;
+        std::optional<ConnectionPool::Lease> obs, auth;
+        std::string auth_host;
+        std::string action_url;
+        std::string form_body; // Credential POST, encoded from the landing page
+        std::string identity_path;
+        AuthStep next = AuthStep::Landing;
+        int reforms = 0; // Credential POSTs answered with the login form again
+
+        LoginState(const std::string& username, const std::string& password, bool debug)
+            : username(username), password(password), debug(debug) {}
+    };
+
+    // Opens a request with the step's timeout
+    std::unique_ptr<HttpRequest> open(AuthStep step, HttpConnection& conn, const std::string& method,
+                                      const std::string& path, const std::string& referer = "");
+    // Sends, waits for the head and reads the body into page. A transport failure or a status
+    // of 400 and above is an error. The view is only valid until the next request
+    AuthResult perform_request(AuthStep step, HttpConnection& conn, const std::string& method, const std::string& path,
+                               std::string_view& body_out, const std::string& body = "",
+                               const std::string& headers = "", const std::string& referer = "");
+
+    // One attempt of a step. Sets state.next on success
+    AuthResult run_step(AuthStep step, LoginState& state);
+    AuthResult step_landing(LoginState& state);
+    AuthResult step_credentials(LoginState& state);
+    AuthResult step_identity(LoginState& state);
+    AuthResult step_dashboard(LoginState& state);
+
+    // Last step of the chain: the JWT endpoint. quiet leaves out the body dump on failure
+    AuthResult fetch_jwt(HttpConnection& obs, bool quiet = false);
+
+    void record(AuthStep step, double ms, const AuthResult& result);
 
 public:
-    TokenFetcher();
-    ~TokenFetcher();
-    std::string get_bearer_token(const std::string& username, const std::string& password, const bool _debug);
+    explicit TokenFetcher(ConnectionPool& pool, const AuthOptions& options = {});
+
+    // Runs the login chain, retrying a step that failed transiently up to options.retries times
+    AuthResult login(const std::string& username, const std::string& password, const bool _debug);
+
+    // One request for a new JWT on the session the cookie jar already holds, no login
+    AuthResult renew_token(const bool _debug);
+
+    bool has_session() const { return !landed_url.empty(); }
+    void restore_session(const std::string& url, const std::string& sub_session) { landed_url = url; sub_session_id = sub_session; }
+    void forget_session();
+    const std::string& get_landed_url() const { return landed_url; }
+    const std::string& get_sub_session_id() const { return sub_session_id; }
+
+    // The session's cookie jar, nullptr if the transport keeps cookies to itself
+    CookieJar* cookies() { return pool.get_transport().cookie_jar(); }
+
+    // Per step attempts, failures and latency histogram into report.section("login")
+    void fill_report(RunReport& report) const;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,274 @@
+#include "token_cache.hpp"
+#include "token.hpp"
+#include "clock.hpp"
+#include "report.hpp"
+#include "session.hpp"
+#include "cookies.hpp"
+#include <algorithm>
+#include <ctime>
+#include <iostream>
+
+// --- INTERNAL HELPERS ---
+
+static long long to_seconds(std::chrono::system_clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::seconds>(tp.time_since_epoch()).count();
+}
+
+// "HH:MM:SS UTC"
+static std::string format_utc(long long s) {
+    std::time_t t = (std::time_t)s;
+    char buf[32];
+    std::strftime(buf, sizeof(buf), "%H:%M:%S UTC", std::gmtime(&t));
+    return buf;
+}
+
+// --- CLASS METHODS ---
+
+TokenCache::TokenCache(TokenFetcher& fetcher, const SystemClock& clock, const std::string& username,
+                       const std::string& password, bool debug, const TokenCacheOptions& options)
+    : fetcher(fetcher), clock(clock), username(username), password(password), debug(debug), options(options) {}
+
+TokenCache::~TokenCache() {
+    stop_refresh();
+}
+
+long long TokenCache::server_now_s() const {
+    return (long long)(clock.server_ms_at(SystemClock::local_ms()) / 1000);
+}
+
+void TokenCache::adopt(const std::string& jwt, long long acquired, const std::string& from) {
+    JwtClaims parsed;
+    if (!decode_jwt(jwt, parsed) && debug) std::cout << "[Debug] JWT payload could not be decoded, assuming a "
+                                                      << options.assumed_lifetime_s << "s lifetime." << std::endl;
+    std::lock_guard<std::mutex> guard(lock);
+    token = jwt;
+    claims = parsed;
+    acquired_s = acquired;
+    expires_s = parsed.exp > 0 ? parsed.exp : acquired + options.assumed_lifetime_s;
+    source = from;
+}
+
+bool TokenCache::load() {
+    if (options.path.empty()) return false;
+    SessionSnapshot saved;
+    std::string load_error;
+    if (!load_session(options.path, password, saved, load_error)) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = load_error;
+        return false;
+    }
+    if (saved.user != username) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = "saved session belongs to another account";
+        return false;
+    }
+
+    // Cookies first: a live session hands out a fresh token in one round trip
+    CookieJar* jar = fetcher.cookies();
+    if (jar && !saved.cookies.empty() && !saved.landed_url.empty()) {
+        std::lock_guard<std::mutex> hold(session);
+        jar->restore(saved.cookies);
+        fetcher.restore_session(saved.landed_url, saved.sub_session_id);
+
+        double started = SystemClock::local_ms();
+        AuthResult result = fetcher.renew_token(debug);
+        if (result.ok()) {
+            adopt(result.bearer.substr(7), server_now_s(), "session");
+            std::cout << "[Auth] Session restored in " << (long long)(SystemClock::local_ms() - started)
+                      << "ms, JWT valid until " << format_utc(expires_at()) << "." << std::endl;
+            save();
+            return true;
+        }
+        if (debug) std::cout << "[Debug] Saved session not renewed (" << result.describe() << "), trying its token alone." << std::endl;
+        fetcher.forget_session();
+    }
+
+    if (saved.token.empty()) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = "saved session holds no token";
+        return false;
+    }
+    adopt(saved.token, saved.acquired_s, "cache");
+    std::lock_guard<std::mutex> guard(lock);
+    if (expires_s <= server_now_s() + options.refresh_margin_s) {
+        token.clear();
+        error = "saved token expires at " + format_utc(expires_s);
+        return false;
+    }
+    return true;
+}
+
+bool TokenCache::save() const {
+    if (options.path.empty()) return true;
+
+    SessionSnapshot snapshot;
+    snapshot.user = username;
+    snapshot.saved_s = server_now_s();
+    snapshot.landed_url = fetcher.get_landed_url();
+    snapshot.sub_session_id = fetcher.get_sub_session_id();
+    if (const CookieJar* jar = fetcher.cookies()) snapshot.cookies = jar->all();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        snapshot.token = token;
+        snapshot.acquired_s = acquired_s;
+        snapshot.expires_s = expires_s;
+    }
+
+    std::string save_error;
+    if (!save_session(options.path, snapshot, password, options.encrypt, save_error)) {
+        std::cout << "[Warning] Session not saved: " << save_error << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TokenCache::acquire() {
+    // Held until the session is saved, the jar must not change while it is copied
+    std::lock_guard<std::mutex> hold(session);
+    AuthResult result;
+    std::string from = "login";
+
+    // A renewal only counts if it brings a later expiry, some servers hand out the same token per session
+    if (fetcher.has_session()) {
+        result = fetcher.renew_token(debug);
+        JwtClaims renewed;
+        if (result.ok() && decode_jwt(result.bearer, renewed) && renewed.exp > expires_at()) {
+            from = "renewal";
+        } else if (debug) {
+            std::cout << "[Debug] Session renewal gave no newer token (" << (result.ok() ? "same expiry" : result.describe())
+                      << "), logging in." << std::endl;
+        }
+    }
+    if (from == "login") result = fetcher.login(username, password, debug);
+
+    if (!result.ok()) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = result.describe();
+        rejected = result.error == AuthError::Rejected;
+        failures++;
+        return false;
+    }
+
+    adopt(result.bearer.substr(7), server_now_s(), from);
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (from == "renewal") renewals++;
+        else logins++;
+        error.clear();
+        rejected = false;
+        std::cout << "[Success] JWT " << (from == "renewal" ? "renewed" : "acquired") << ", valid until " << format_utc(expires_s);
+        if (claims.lifetime() > 0) std::cout << " (lifetime " << claims.lifetime() << "s)";
+        std::cout << "." << std::endl;
+    }
+    save();
+    return true;
+}
+
+long long TokenCache::next_refresh(long long now, long long needed_s, long long cutoff_s) const {
+    if (now > cutoff_s) return -1;
+    if (token.empty()) return now;
+
+    long long lifetime = claims.lifetime() > 0 ? claims.lifetime() : expires_s - acquired_s;
+    // A margin over half the lifetime would have every fresh token due again straight away
+    long long margin = lifetime > 0 ? std::min<long long>(options.refresh_margin_s, lifetime / 2) : options.refresh_margin_s;
+    long long when = expires_s - margin; // Never let the token lapse
+    if (expires_s < needed_s && lifetime > 0) {
+        // Earliest login whose token still lasts until needed. A shorter-lived one cannot, the
+        // last login before the cutoff comes closest
+        when = std::min(when, needed_s - lifetime + margin);
+        if (when >= cutoff_s) {
+            if (acquired_s >= cutoff_s) return -1; // Nothing fresher is possible
+            when = cutoff_s;
+        }
+    } else if (when > cutoff_s) {
+        return -1; // Lasts through the fire
+    }
+    return std::max(when, now);
+}
+
+void TokenCache::start_refresh(std::chrono::system_clock::time_point needed, std::chrono::system_clock::time_point cutoff) {
+    if (worker.joinable()) return;
+    stopping = false;
+    const long long needed_s = to_seconds(needed), cutoff_s = to_seconds(cutoff);
+
+    worker = std::thread([this, needed_s, cutoff_s]() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!stopping) {
+            long long now = server_now_s();
+            long long when = next_refresh(now, needed_s, cutoff_s);
+            if (when < 0) {
+                wake.wait(guard, [this]() { return stopping; });
+                break;
+            }
+            if (when > now) {
+                // Woken every minute at most, the server clock estimate keeps improving meanwhile
+                long long wait_ms = std::min(when - now, 60LL) * 1000;
+                wake.wait_for(guard, std::chrono::milliseconds(wait_ms), [this]() { return stopping; });
+                continue;
+            }
+
+            guard.unlock();
+            std::cout << "[Auth] Refreshing the JWT in the background..." << std::endl;
+            bool ok = acquire();
+            guard.lock();
+            if (ok) {
+                refreshes++;
+            } else if (rejected) {
+                // Every further attempt with the same password would count against the account
+                std::cout << "[Warning] Background login failed: " << error << ", not retrying." << std::endl;
+                wake.wait(guard, [this]() { return stopping; });
+                break;
+            } else {
+                std::cout << "[Warning] Background login failed: " << error << ", retrying in " << options.retry_s << "s." << std::endl;
+                wake.wait_for(guard, std::chrono::seconds(options.retry_s), [this]() { return stopping; });
+            }
+        }
+    });
+}
+
+void TokenCache::stop_refresh() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_all();
+    if (worker.joinable()) worker.join();
+}
+
+bool TokenCache::valid_at(std::chrono::system_clock::time_point tp) const {
+    std::lock_guard<std::mutex> guard(lock);
+    return !token.empty() && expires_s > to_seconds(tp);
+}
+
+std::string TokenCache::bearer() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return token.empty() ? std::string() : "Bearer " + token;
+}
+
+long long TokenCache::expires_at() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return expires_s;
+}
+
+std::string TokenCache::get_source() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return source;
+}
+
+std::string TokenCache::last_error() const {
+    std::lock_guard<std::mutex> guard(lock);
+    return error;
+}
+
+void TokenCache::fill_report(RunReport& report) const {
+    std::lock_guard<std::mutex> guard(lock);
+    auto& auth = report.section("auth");
+    auth["source"] = source;
+    auth["expires_s"] = expires_s;
+    auth["lifetime_s"] = claims.lifetime();
+    auth["logins"] = logins;
+    auth["renewals"] = renewals;
+    auth["refreshes"] = refreshes;
+    auth["failures"] = failures;
+    if (!error.empty()) auth["last_error"] = error;
+}
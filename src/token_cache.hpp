@@ -0,0 +1,95 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "jwt.hpp"
+
+class TokenFetcher;
+class SystemClock;
+class RunReport;
+
+// Knobs from the "auth" config block
+struct TokenCacheOptions {
+    std::string path = "data/session.bin"; // Session snapshot, empty: keep everything in memory only
+    bool encrypt = true;          // Seal the file (DPAPI on Windows, AES-GCM keyed by the password elsewhere)
+    int refresh_margin_s = 120;   // A token is replaced this long before it expires
+    int retry_s = 10;             // Pause after a failed login before the next attempt
+    int assumed_lifetime_s = 300; // For a token without an exp claim
+};
+
+// Holds the bearer token for the fire path. The JWT's exp claim decides when a login is due:
+// a token that lasts through the fire is taken from the saved session or acquired at startup, one
+// that does not is re-acquired in the background at the earliest moment its lifetime still
+// covers the fire, so no login runs on the critical timeline. A new token is asked for on the
+// existing session first (one request), the full login chain only runs when that fails.
+// The session (cookies, token) is saved after every change. All times are server time.
+class TokenCache {
+private:
+    TokenFetcher& fetcher;
+    const SystemClock& clock;
+    std::string username, password;
+    bool debug;
+    TokenCacheOptions options;
+
+    mutable std::mutex lock; // Guards everything below up to the worker
+    std::string token;       // Raw JWT, without "Bearer "
+    JwtClaims claims;
+    long long acquired_s = 0;
+    long long expires_s = 0; // exp, or acquired + assumed lifetime
+    std::string source;      // "session" (restored and renewed), "cache" (saved token only), "renewal" or "login"
+    int logins = 0;
+    int renewals = 0;
+    int failures = 0;
+    int refreshes = 0;
+    std::string error;
+    bool rejected = false;   // The last login failed on the credentials, retrying would not help
+
+    // Held for the whole login, the fetcher's connection pool is shared with the main thread
+    std::mutex session;
+
+    std::thread worker;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    long long server_now_s() const;
+    // Server second at which the next background login should start, -1 if none is needed. A
+    // login due after cutoff_s is clamped to it and still runs at cutoff_s itself, so a token too
+    // short-lived to reach needed_s is at least replaced as late as allowed. -1 after cutoff_s,
+    // and once the token was acquired at or after that clamped login
+    long long next_refresh(long long now, long long needed_s, long long cutoff_s) const;
+    bool save() const;
+    void adopt(const std::string& jwt, long long acquired, const std::string& from);
+
+public:
+    TokenCache(TokenFetcher& fetcher, const SystemClock& clock, const std::string& username,
+               const std::string& password, bool debug, const TokenCacheOptions& options);
+    ~TokenCache();
+
+    // Restores the saved session: its cookies go back into the jar and one request checks that
+    // the server still knows them, which also brings a fresh token. A dead session falls back to
+    // the saved token alone. False (see last_error()) if there is no session file, it belongs to
+    // another account, or no token from it lasts beyond the refresh margin
+    bool load();
+
+    // Renews on the current session, or logs in, and saves the result
+    bool acquire();
+
+    // Keeps a token that is valid at needed in hand until stop_refresh(). No login starts after
+    // cutoff, the main thread takes the pool back from there on
+    void start_refresh(std::chrono::system_clock::time_point needed, std::chrono::system_clock::time_point cutoff);
+    void stop_refresh();
+
+    // Blocks background logins while the caller uses the shared pool
+    std::unique_lock<std::mutex> hold_session() { return std::unique_lock<std::mutex>(session); }
+
+    bool valid_at(std::chrono::system_clock::time_point tp) const;
+    // "Bearer <jwt>", empty without a token
+    std::string bearer() const;
+    long long expires_at() const;
+    std::string get_source() const;
+    std::string last_error() const;
+
+    void fill_report(RunReport& report) const;
+};
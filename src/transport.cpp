@@ -0,0 +1,25 @@
+#include "transport.hpp"
+#include <chrono>
+#include <thread>
+#ifdef _WIN32
+#include "winhttp_transport.hpp"
+#endif
+#ifdef __linux__
+#include "linux_transport.hpp"
+#endif
+
+int HttpTransport::poll(int timeout_ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(timeout_ms));
+    return 0;
+}
+
+std::unique_ptr<HttpTransport> make_transport(const std::string& name, const std::string& user_agent,
+                                              const TransportOptions& options) {
+#ifdef _WIN32
+    if (name == "auto" || name == "winhttp") return std::make_unique<WinHttpTransport>(user_agent, options);
+#endif
+#ifdef __linux__
+    if (name == "auto" || name == "linux") return std::make_unique<LinuxTransport>(user_agent, options);
+#endif
+    return nullptr;
+}
@@ -0,0 +1,135 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <memory>
+#include <functional>
+#include <cstddef>
+
+class Resolver;
+class RunReport;
+class ResponseBuffer;
+class CookieJar;
+
+// Backend-neutral HTTP layer. The clock, auth and firing logic only talk to these
+// interfaces, so the same flow runs on WinHTTP (Windows) and on epoll + OpenSSL (Linux).
+
+// A single request/response exchange
+class HttpRequest {
+public:
+    virtual ~HttpRequest() = default;
+
+    // Renders the header block ("Name: value\r\n" lines) and the body into the backend's
+    // wire form. The body must stay valid until the response is received. May allocate
+    virtual bool stage(std::string_view headers, const char* body, size_t total_len) = 0;
+
+    // Puts the staged request on the wire up to body offset upto. Calling it again with a
+    // larger offset streams the rest. Does not allocate, a stale request fails instead
+    virtual bool transmit(size_t upto) = 0;
+
+    // True once the staged wire form no longer fits the connection, e.g. it was reconnected onto
+    // a new HTTP/2 session since stage(). Nothing is sent yet, stage() it again
+    virtual bool is_stale() const { return false; }
+
+    // Fails a send or receive wait of this exchange (redirects included) that makes no progress
+    // for timeout_ms. Set it before stage(), backends start every request at 30 s
+    virtual void set_timeout(int timeout_ms) { (void)timeout_ms; }
+
+    bool send(std::string_view headers = {}, const std::string& body = "") {
+        return stage(headers, body.data(), body.size()) && transmit(body.size());
+    }
+
+    // Waits for the status line and headers (redirects are followed)
+    virtual bool receive() = 0;
+
+    // receive() without blocking the caller: done runs from HttpTransport::poll() (or from any
+    // other wait on the same transport) once the headers are in. The request must outlive it.
+    // Backends without an event loop run receive() on the spot
+    virtual void receive_async(std::function<void(bool ok)> done) { done(receive()); }
+
+    virtual int status_code() = 0;
+
+    // Value of a response header, empty if it is missing
+    virtual std::string query_header(const std::string& name) = 0;
+
+    // Reads the rest of the response body into out (cleared first) and returns a view of it.
+    // The view lives as long as out is not reused, so one buffer serves a whole request chain
+    virtual std::string_view read_body(ResponseBuffer& out) = 0;
+
+    // Checked against the whole body read so far, each time more of it has arrived
+    using BodyCheck = std::function<bool(std::string_view body)>;
+
+    // read_body() that stops as soon as done returns true, so a caller can act on the start of a
+    // page while the rest is still on the wire. What is left unread is dropped with the request.
+    // Backends that cannot stream the body call done once, on the whole of it
+    virtual std::string_view read_body_until(ResponseBuffer& out, const BodyCheck& done) {
+        std::string_view body = read_body(out);
+        done(body);
+        return body;
+    }
+
+    // Final URL of the exchange after redirects
+    virtual std::string url() = 0;
+
+    // Human readable description of the last failure
+    virtual std::string last_error() const = 0;
+
+    // True if the last failure was a timeout rather than a refused or broken connection
+    virtual bool timed_out() const { return false; }
+};
+
+// Connection to one host, requests are opened on top of it
+class HttpConnection {
+public:
+    virtual ~HttpConnection() = default;
+
+    // referer can be left empty
+    virtual std::unique_ptr<HttpRequest> open(const std::string& method, const std::string& path,
+                                              const std::string& referer = "") = 0;
+
+    // Establishes TCP + TLS now instead of on the first request, so a later request
+    // goes out on an already negotiated socket
+    virtual bool preconnect() = 0;
+
+    // Connection level keep-alive that does not take a request slot (an HTTP/2 PING). done runs
+    // from HttpTransport::poll(). Returns false if the protocol has none, use a HEAD probe then
+    virtual bool ping_async(std::function<void(bool ok)> done) { (void)done; return false; }
+
+    virtual const std::string& host() const = 0;
+};
+
+// Backend knobs from the "network" config block
+struct TransportOptions {
+    std::string event_loop = "auto"; // Linux readiness backend: "auto", "io_uring" or "epoll"
+    bool http2 = true;               // Offer HTTP/2, HTTP/1.1 stays the fallback
+    bool low_priority = false;       // Background lanes (clock probes): sockets marked as lower-effort traffic
+    std::string extra_ca_pem;        // Certificate trusted next to the system store (Linux), the TLS bench's loopback server
+};
+
+// Session level object (cookies, TLS settings, user agent)
+class HttpTransport {
+public:
+    virtual ~HttpTransport() = default;
+
+    // Connections are lazy, the socket is opened by the first request
+    virtual std::unique_ptr<HttpConnection> connect(const std::string& host, int port = 443) = 0;
+
+    virtual const char* name() const = 0;
+
+    // Pinned DNS results to connect with. Backends that resolve on their own ignore it
+    virtual void set_resolver(Resolver* resolver) { (void)resolver; }
+
+    // The session's cookies, so they can be saved and restored across runs
+    virtual CookieJar* cookie_jar() = 0;
+
+    // Adds backend specific measurements (handshakes, resumption) to the run report
+    virtual void fill_report(RunReport& report) const { (void)report; }
+
+    // Drives asynchronous exchanges for up to timeout_ms, returns how many made progress.
+    // Use it instead of sleeping while requests are in flight
+    virtual int poll(int timeout_ms);
+};
+
+// Creates a backend by name: "winhttp", "linux" or "auto" (platform default).
+// Returns nullptr if the backend is not available on this platform
+std::unique_ptr<HttpTransport> make_transport(const std::string& name, const std::string& user_agent,
+                                              const TransportOptions& options = {});
@@ -0,0 +1,110 @@
+#include "urlform.hpp"
+#include <cstring>
+
+// --- INTERNAL HELPERS ---
+
+static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+// Per byte: 1 if the encoder copies it as is, 1 if the decoder does (anything but % and +), and
+// the nibble value of a hex digit or -1
+struct FormTables {
+    unsigned char unreserved[256] = {};
+    unsigned char plain[256] = {};
+    signed char hex[256] = {};
+
+    constexpr FormTables() {
+        for (int c = 0; c < 256; c++) {
+            bool alnum = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+            unreserved[c] = alnum || c == '-' || c == '_' || c == '.' || c == '~';
+            plain[c] = c != '%' && c != '+';
+            hex[c] = (c >= '0' && c <= '9') ? c - '0' : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        }
+    }
+};
+
+static constexpr FormTables TABLES;
+
+// End of the run of bytes starting at p that table lets through. Unrolled by four, the loads and
+// lookups of one step are independent of each other
+static const unsigned char* run_end(const unsigned char* table, const unsigned char* p, const unsigned char* end) {
+    while (end - p >= 4) {
+        if (!table[p[0]]) return p;
+        if (!table[p[1]]) return p + 1;
+        if (!table[p[2]]) return p + 2;
+        if (!table[p[3]]) return p + 3;
+        p += 4;
+    }
+    while (p < end && table[*p]) p++;
+    return p;
+}
+
+// --- ENCODER ---
+
+void url_encode_append(std::string& out, std::string_view value) {
+    // Worst case every byte becomes three, the buffer is cut back to what was written at the end
+    size_t start = out.size();
+    out.resize(start + value.size() * 3);
+    char* w = &out[0] + start;
+
+    const unsigned char* p = (const unsigned char*)value.data();
+    const unsigned char* end = p + value.size();
+    while (p < end) {
+        const unsigned char* run = run_end(TABLES.unreserved, p, end);
+        std::memcpy(w, p, (size_t)(run - p));
+        w += run - p;
+        if (run == end) break;
+        w[0] = '%';
+        w[1] = HEX_DIGITS[*run >> 4];
+        w[2] = HEX_DIGITS[*run & 15];
+        w += 3;
+        p = run + 1;
+    }
+    out.resize((size_t)(w - out.data()));
+}
+
+std::string url_encode(std::string_view value) {
+    std::string out;
+    url_encode_append(out, value);
+    return out;
+}
+
+void append_form_field(std::string& body, std::string_view name, std::string_view value) {
+    if (!body.empty()) body += '&';
+    body.append(name.data(), name.size());
+    body += '=';
+    url_encode_append(body, value);
+}
+
+// --- DECODER ---
+
+bool url_decode(std::string_view value, std::string& out) {
+    // Decoding never grows the text
+    size_t start = out.size();
+    out.resize(start + value.size());
+    char* w = &out[0] + start;
+
+    const unsigned char* p = (const unsigned char*)value.data();
+    const unsigned char* end = p + value.size();
+    while (p < end) {
+        const unsigned char* special = run_end(TABLES.plain, p, end);
+        std::memcpy(w, p, (size_t)(special - p));
+        w += special - p;
+        if (special == end) break;
+
+        if (*special == '+') {
+            *w++ = ' ';
+            p = special + 1;
+            continue;
+        }
+        int hi = end - special < 3 ? -1 : TABLES.hex[special[1]];
+        int lo = hi < 0 ? -1 : TABLES.hex[special[2]];
+        if (lo < 0) {
+            out.resize(start);
+            return false;
+        }
+        *w++ = (char)((hi << 4) | lo);
+        p = special + 3;
+    }
+    out.resize((size_t)(w - out.data()));
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// application/x-www-form-urlencoded values without streams or per-byte appends. The encoder
+// keeps the unreserved bytes (A-Z a-z 0-9 - _ . ~) and writes every other byte as %XX with upper
+// case hex, the same output the old ostringstream encoder produced.
+
+// Appends the encoded value to out
+void url_encode_append(std::string& out, std::string_view value);
+std::string url_encode(std::string_view value);
+
+// Appends "&name=value" (no '&' for the first field) to a form body. The name is taken as is
+void append_form_field(std::string& body, std::string_view name, std::string_view value);
+
+// Appends the decoded value to out, '+' reads as a space. False on a broken %XX escape, out is
+// then left as it was
+bool url_decode(std::string_view value, std::string& out);
@@ -0,0 +1,184 @@
+#include "wake.hpp"
+#include "clock.hpp"
+#include "report.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <sched.h>
+#include <time.h>
+#endif
+
+// --- INTERNAL HELPERS ---
+
+static const double MIN_GUARD_MS = 0.05;
+static const double MAX_GUARD_MS = 5.0;
+// Guard when the measured overshoot is above MAX_GUARD_MS (coarse timers): spin the whole tail
+static const double SPIN_GUARD_MS = 50.0;
+
+#ifdef _WIN32
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+// Per thread high resolution waitable timer (Windows 10 1803+), NULL where it is not available.
+// Plain sleeps on Windows wake on the 15.6 ms system tick
+static HANDLE wait_timer() {
+    thread_local struct Timer {
+        HANDLE handle = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+        ~Timer() { if (handle) CloseHandle(handle); }
+    } timer;
+    return timer.handle;
+}
+#endif
+
+// Tells the core we are spinning: frees execution resources for the sibling hyperthread and
+// avoids the memory-order flush when the loop exits
+static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    __asm__ __volatile__("yield");
+#else
+    std::this_thread::yield();
+#endif
+}
+
+// Pins the calling thread to one core for the spin and restores the old affinity afterwards
+class SpinPin {
+private:
+#ifdef _WIN32
+    DWORD_PTR previous = 0;
+#else
+    cpu_set_t previous;
+#endif
+    bool pinned = false;
+
+public:
+    explicit SpinPin(int cpu) {
+        if (cpu < 0) return;
+#ifdef _WIN32
+        previous = SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu);
+        pinned = previous != 0;
+#else
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pinned = sched_getaffinity(0, sizeof(previous), &previous) == 0 && sched_setaffinity(0, sizeof(set), &set) == 0;
+#endif
+    }
+
+    ~SpinPin() {
+        if (!pinned) return;
+#ifdef _WIN32
+        SetThreadAffinityMask(GetCurrentThread(), previous);
+#else
+        sched_setaffinity(0, sizeof(previous), &previous);
+#endif
+    }
+};
+
+// --- CLASS METHODS ---
+
+void WakeEngine::sleep_until(double local_deadline) {
+    double remaining = local_deadline - SystemClock::local_ms();
+    if (remaining <= 0) return;
+#ifdef __linux__
+    // clock_nanosleep cannot use MONOTONIC_RAW. CLOCK_MONOTONIC differs from it only by NTP
+    // slewing (at most 500 ppm), callers re-check on the raw clock after waking
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    long long ns = (long long)ts.tv_nsec + std::llround(remaining * 1e6);
+    ts.tv_sec += (time_t)(ns / 1000000000LL);
+    ts.tv_nsec = (long)(ns % 1000000000LL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#else
+#ifdef _WIN32
+    if (HANDLE timer = wait_timer()) {
+        LARGE_INTEGER due;
+        due.QuadPart = -(LONGLONG)std::llround(remaining * 1e4); // Relative, in 100 ns units
+        if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE) && WaitForSingleObject(timer, INFINITE) == WAIT_OBJECT_0) return;
+    }
+#endif
+    std::this_thread::sleep_until(std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double, std::milli>(remaining)));
+#endif
+}
+
+void WakeEngine::calibrate(int rounds) {
+    overshoot_us.clear();
+    wake_error_us.clear();
+
+    // Short sleeps at staggered lengths, so the timer slack and tick alignment all show up
+    for (int i = 0; i < rounds; i++) {
+        double deadline = SystemClock::local_ms() + 0.5 + (i % 4) * 0.5;
+        sleep_until(deadline);
+        overshoot_us.push_back((SystemClock::local_ms() - deadline) * 1000.0);
+    }
+    // The guard must cover the measured overshoot. A timer too coarse for MAX_GUARD_MS is not
+    // trusted near the deadline at all, the last SPIN_GUARD_MS are spun instead
+    guard_ms = std::max(percentile(overshoot_us, 99) / 1000.0 + MIN_GUARD_MS, MIN_GUARD_MS);
+    if (guard_ms > MAX_GUARD_MS) guard_ms = SPIN_GUARD_MS;
+
+    for (int i = 0; i < rounds / 4; i++) {
+        wake_error_us.push_back(wait_until(SystemClock::local_ms() + 2.0 + (i % 3)));
+    }
+    waited = false;
+}
+
+double WakeEngine::wait_until(double local_deadline) {
+    // Pinned before the sleep, so the thread wakes up on the spin core and the affinity change
+    // (which may move the thread) never falls into the guard window
+    SpinPin pin(spin_cpu);
+    sleep_until(local_deadline - guard_ms);
+
+    double now;
+    while ((now = SystemClock::local_ms()) < local_deadline) cpu_relax();
+
+    last_error_us = (now - local_deadline) * 1000.0;
+    waited = true;
+    return last_error_us;
+}
+
+double WakeEngine::percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0;
+    size_t k = (size_t)std::llround(p / 100.0 * (double)(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+void WakeEngine::print_summary() const {
+    std::cout << std::fixed << std::setprecision(1)
+              << "[Wake] Sleep overshoot p50 " << percentile(overshoot_us, 50) << "us, p99 " << percentile(overshoot_us, 99)
+              << "us, guard " << guard_ms * 1000.0 << "us" << (guard_ms >= SPIN_GUARD_MS ? " (timer too coarse, spinning)" : "") << std::endl
+              << "[Wake] Wake error p50 " << percentile(wake_error_us, 50) << "us, p90 " << percentile(wake_error_us, 90)
+              << "us, p99 " << percentile(wake_error_us, 99) << "us, max " << percentile(wake_error_us, 100) << "us"
+              << std::defaultfloat << std::endl;
+}
+
+void WakeEngine::fill_report(RunReport& report) const {
+    auto& wake = report.section("wake");
+    wake["guard_us"] = guard_ms * 1000.0;
+    wake["spin_cpu"] = spin_cpu;
+    wake["overshoot_us"] = {
+        {"p50", percentile(overshoot_us, 50)},
+        {"p99", percentile(overshoot_us, 99)},
+        {"max", percentile(overshoot_us, 100)}
+    };
+    wake["calibration_error_us"] = {
+        {"p50", percentile(wake_error_us, 50)},
+        {"p90", percentile(wake_error_us, 90)},
+        {"p99", percentile(wake_error_us, 99)},
+        {"max", percentile(wake_error_us, 100)}
+    };
+    if (waited) wake["fire_error_us"] = last_error_us;
+}
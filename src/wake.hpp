@@ -0,0 +1,40 @@
+#pragma once
+#include <vector>
+
+class RunReport;
+
+// Wakes a thread at a deadline on the local timeline (SystemClock::local_ms()) with sub-100us
+// error. An absolute sleep ends a calibrated guard interval early, the rest is a pause/yield
+// spin, optionally on a pinned core. The guard comes from measuring how late this host's
+// sleeps actually wake up.
+class WakeEngine {
+private:
+    double guard_ms = 1.0;             // Sleep ends this much before the deadline, set by calibrate()
+    int spin_cpu = -1;                 // Core to spin on, -1 leaves the affinity alone
+    std::vector<double> overshoot_us;  // Calibration: how late the absolute sleeps woke up
+    std::vector<double> wake_error_us; // Calibration: error of complete waits (sleep + spin)
+    double last_error_us = 0;          // Error of the last real wait
+    bool waited = false;
+
+public:
+    // Absolute sleep on the local timeline, may wake a little late
+    static void sleep_until(double local_deadline);
+
+    // Measures the sleep overshoot over rounds short sleeps and sets the guard from its p99,
+    // then checks the achieved error with a few complete waits
+    void calibrate(int rounds = 200);
+
+    // Sleeps and spins until local_deadline, returns how late it woke (us)
+    double wait_until(double local_deadline);
+
+    void set_spin_cpu(int cpu) { spin_cpu = cpu; }
+    double guard() const { return guard_ms; }
+    // Error of the last wait_until(), false before the first one outside calibration
+    bool last_error(double& error_us) const { error_us = last_error_us; return waited; }
+
+    // Percentile p (0..100) of values, 0 for an empty set
+    static double percentile(std::vector<double> values, double p);
+
+    void print_summary() const;
+    void fill_report(RunReport& report) const;
+};
@@ -0,0 +1,293 @@
+#ifdef _WIN32
+#include "winhttp_transport.hpp"
+#include "memory.hpp"
+#include <cctype>
+#include <vector>
+
+#pragma comment(lib, "winhttp.lib")
+
+// --- INTERNAL HELPERS ---
+
+const int MAX_REDIRECTS = 10;
+
+std::wstring widen(std::string_view s) {
+    if (s.empty()) return L"";
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), NULL, 0);
+    std::wstring out(n, L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), (int)s.size(), &out[0], n);
+    return out;
+}
+
+std::string narrow(const std::wstring& s) {
+    if (s.empty()) return "";
+    int n = WideCharToMultiByte(CP_UTF8, 0, s.data(), (int)s.size(), NULL, 0, NULL, NULL);
+    std::string out(n, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, s.data(), (int)s.size(), &out[0], n, NULL, NULL);
+    return out;
+}
+
+// Opens a request with WinHTTP's own cookie and redirect handling turned off
+static HINTERNET open_request(HINTERNET connect, const std::string& method, const std::string& path, const std::string& referer) {
+    std::wstring wMethod = widen(method), wPath = widen(path), wReferer = widen(referer);
+    HINTERNET hRequest = WinHttpOpenRequest(connect, wMethod.c_str(), wPath.c_str(),
+                                            NULL, wReferer.empty() ? WINHTTP_NO_REFERER : wReferer.c_str(),
+                                            WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                            WINHTTP_FLAG_SECURE);
+    if (!hRequest) return NULL;
+    DWORD features = WINHTTP_DISABLE_COOKIES | WINHTTP_DISABLE_REDIRECTS;
+    WinHttpSetOption(hRequest, WINHTTP_OPTION_DISABLE_FEATURE, &features, sizeof(features));
+    return hRequest;
+}
+
+static bool same_host(const std::string& a, const std::string& b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::tolower((unsigned char)a[i]) != std::tolower((unsigned char)b[i])) return false;
+    }
+    return true;
+}
+
+// --- REQUEST ---
+
+WinHttpRequest::WinHttpRequest(WinHttpTransport& transport, HINTERNET connect, HINTERNET request, const std::string& host,
+                               const std::string& method, const std::string& path, const std::string& referer)
+    : transport(transport), hConnect(connect), hRequest(request), host(host), method(method), path(path), referer(referer) {}
+
+WinHttpRequest::~WinHttpRequest() {
+    if (hRequest) WinHttpCloseHandle(hRequest);
+}
+
+void WinHttpRequest::set_timeout(int ms) {
+    timeout_ms = ms;
+    // Resolve, connect, send and receive each get the limit
+    if (ms > 0) WinHttpSetTimeouts(hRequest, ms, ms, ms, ms);
+}
+
+bool WinHttpRequest::fail() {
+    error = GetLastError();
+    return false;
+}
+
+bool WinHttpRequest::stage(std::string_view headers, const char* body, size_t total_len) {
+    this->headers.assign(headers.data(), headers.size());
+    std::string cookie = transport.cookies().header_for(host, path);
+    wHeaders = widen(cookie.empty() ? this->headers : this->headers + "Cookie: " + cookie + "\r\n");
+    this->body = body;
+    body_total = total_len;
+    sent_upto = 0;
+    sent = false;
+    return true;
+}
+
+bool WinHttpRequest::transmit(size_t upto) {
+    if (upto > body_total || upto < sent_upto) {
+        error = ERROR_INVALID_PARAMETER;
+        return false;
+    }
+
+    if (!sent) {
+        // First call sends the headers with the first part of the body, WinHTTP expects
+        // the rest (up to body_total) through WinHttpWriteData
+        if (!WinHttpSendRequest(hRequest,
+                                wHeaders.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : wHeaders.c_str(),
+                                wHeaders.empty() ? 0 : (DWORD)-1L,
+                                upto ? (LPVOID)body : WINHTTP_NO_REQUEST_DATA, (DWORD)upto,
+                                (DWORD)body_total, 0)) {
+            return fail();
+        }
+        sent = true;
+    } else if (upto > sent_upto) {
+        DWORD written = 0;
+        if (!WinHttpWriteData(hRequest, (LPCVOID)(body + sent_upto), (DWORD)(upto - sent_upto), &written) ||
+            written != upto - sent_upto) {
+            return fail();
+        }
+    }
+    sent_upto = upto;
+    return true;
+}
+
+bool WinHttpRequest::receive() {
+    for (int redirects = 0; ; redirects++) {
+        if (!WinHttpReceiveResponse(hRequest, NULL)) return fail();
+        store_cookies();
+
+        int status = status_code();
+        std::string location = query_header("Location");
+        bool redirect = status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+        // 307/308 would need the original body replayed, hand those back to the caller instead
+        if (!redirect || location.empty() || redirects >= MAX_REDIRECTS ||
+            ((status == 307 || status == 308) && body_total > 0)) {
+            return true;
+        }
+        if (location.compare(0, 7, "http://") == 0) return true; // Never downgrade to plain HTTP
+        if (!follow(status, location)) return false;
+    }
+}
+
+void WinHttpRequest::store_cookies() {
+    DWORD index = 0;
+    while (true) {
+        DWORD size = 0;
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_SET_COOKIE, WINHTTP_HEADER_NAME_BY_INDEX,
+                            WINHTTP_NO_OUTPUT_BUFFER, &size, &index);
+        if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) return;
+
+        // index moves on to the next Set-Cookie line when the read succeeds
+        std::vector<wchar_t> buffer(size / sizeof(wchar_t) + 1);
+        if (!WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_SET_COOKIE, WINHTTP_HEADER_NAME_BY_INDEX,
+                                 buffer.data(), &size, &index)) return;
+        transport.cookies().store(host, path, narrow(std::wstring(buffer.data(), size / sizeof(wchar_t))));
+    }
+}
+
+bool WinHttpRequest::follow(int status, const std::string& location) {
+    // Drain the redirect body so its socket goes back to the keep-alive pool
+    char discard[4096];
+    DWORD available = 0, read = 0;
+    while (WinHttpQueryDataAvailable(hRequest, &available) && available > 0) {
+        if (!WinHttpReadData(hRequest, discard, available < sizeof(discard) ? available : (DWORD)sizeof(discard), &read) || read == 0) break;
+    }
+
+    std::string new_host = host;
+    if (location.compare(0, 8, "https://") == 0) {
+        size_t slash = location.find('/', 8);
+        new_host = location.substr(8, slash == std::string::npos ? std::string::npos : slash - 8);
+        path = slash == std::string::npos ? "/" : location.substr(slash);
+    } else if (location[0] == '/') {
+        path = location;
+    } else {
+        size_t dir = path.rfind('/', path.find('?'));
+        path = path.substr(0, dir + 1) + location;
+    }
+
+    if (status == 303 || ((status == 301 || status == 302) && method == "POST")) {
+        method = "GET";
+        headers.clear();
+        body = nullptr;
+        body_total = 0;
+    }
+
+    if (!same_host(new_host, host)) {
+        hop = transport.connect_host(new_host);
+        if (!hop) return fail();
+        hConnect = hop->handle();
+        host = new_host;
+    }
+
+    WinHttpCloseHandle(hRequest);
+    hRequest = open_request(hConnect, method, path, referer);
+    if (!hRequest) return fail();
+    if (timeout_ms > 0) set_timeout(timeout_ms);
+    return stage(headers, body, body_total) && transmit(body_total);
+}
+
+int WinHttpRequest::status_code() {
+    DWORD code = 0, size = sizeof(code);
+    WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                        WINHTTP_HEADER_NAME_BY_INDEX, &code, &size, WINHTTP_NO_HEADER_INDEX);
+    return (int)code;
+}
+
+std::string WinHttpRequest::query_header(const std::string& name) {
+    std::wstring wName = widen(name);
+    DWORD size = 0;
+    WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CUSTOM, wName.c_str(), WINHTTP_NO_OUTPUT_BUFFER, &size, WINHTTP_NO_HEADER_INDEX);
+    if (GetLastError() != ERROR_INSUFFICIENT_BUFFER || size == 0) return "";
+
+    std::vector<wchar_t> buffer(size / sizeof(wchar_t) + 1);
+    if (!WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CUSTOM, wName.c_str(), buffer.data(), &size, WINHTTP_NO_HEADER_INDEX)) return "";
+    return narrow(std::wstring(buffer.data(), size / sizeof(wchar_t)));
+}
+
+std::string_view WinHttpRequest::read_body(ResponseBuffer& out) {
+    out.clear();
+    DWORD dwSize = 0;
+    while (WinHttpQueryDataAvailable(hRequest, &dwSize) && dwSize > 0) {
+        // WinHTTP copies straight into the arena, no per-chunk buffer
+        char* dst = out.prepare(dwSize);
+        DWORD dwDownloaded = 0;
+        if (!dst || !WinHttpReadData(hRequest, (LPVOID)dst, dwSize, &dwDownloaded)) {
+            fail();
+            break;
+        }
+        out.commit(dwDownloaded);
+    }
+    return out.view();
+}
+
+std::string WinHttpRequest::url() {
+    DWORD size = 0;
+    WinHttpQueryOption(hRequest, WINHTTP_OPTION_URL, NULL, &size);
+    if (size == 0) return "";
+
+    std::vector<wchar_t> buffer(size / sizeof(wchar_t) + 1);
+    if (!WinHttpQueryOption(hRequest, WINHTTP_OPTION_URL, buffer.data(), &size)) return "";
+    return narrow(buffer.data());
+}
+
+std::string WinHttpRequest::last_error() const {
+    std::string msg = std::to_string(error);
+    if (error == ERROR_WINHTTP_CANNOT_CONNECT) msg += " (Cannot connect to server.)";
+    if (error == ERROR_WINHTTP_SECURE_FAILURE) msg += " (SSL/TLS handshake error.)";
+    if (error == ERROR_WINHTTP_TIMEOUT) msg += " (Request timed out.)";
+    return msg;
+}
+
+// --- CONNECTION ---
+
+WinHttpConnection::WinHttpConnection(WinHttpTransport& transport, HINTERNET connect, const std::string& host)
+    : transport(transport), hConnect(connect), host_name(host) {}
+
+WinHttpConnection::~WinHttpConnection() {
+    if (hConnect) WinHttpCloseHandle(hConnect);
+}
+
+std::unique_ptr<HttpRequest> WinHttpConnection::open(const std::string& method, const std::string& path,
+                                                     const std::string& referer) {
+    HINTERNET hRequest = open_request(hConnect, method, path, referer);
+    if (!hRequest) return nullptr;
+    return std::make_unique<WinHttpRequest>(transport, hConnect, hRequest, host_name, method, path, referer);
+}
+
+// WinHTTP has no explicit connect call. A completed HEAD leaves the negotiated socket
+// in the session's keep-alive pool, where the next request on this host picks it up.
+bool WinHttpConnection::preconnect() {
+    auto request = open("HEAD", "/");
+    return request && request->send() && request->receive() && request->status_code() > 0;
+}
+
+// --- TRANSPORT ---
+
+WinHttpTransport::WinHttpTransport(const std::string& user_agent, const TransportOptions& options) {
+    hSession = WinHttpOpen(widen(user_agent).c_str(),
+                           WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                           WINHTTP_NO_PROXY_NAME,
+                           WINHTTP_NO_PROXY_BYPASS, 0);
+
+    DWORD protocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
+    WinHttpSetOption(hSession, WINHTTP_OPTION_SECURE_PROTOCOLS, &protocols, sizeof(protocols));
+
+    // WinHTTP does the framing and HPACK itself (Windows 10 1607+), older systems ignore the option
+    if (options.http2) {
+        DWORD http2 = WINHTTP_PROTOCOL_FLAG_HTTP2;
+        WinHttpSetOption(hSession, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &http2, sizeof(http2));
+    }
+}
+
+WinHttpTransport::~WinHttpTransport() {
+    if (hSession) WinHttpCloseHandle(hSession);
+}
+
+std::unique_ptr<HttpConnection> WinHttpTransport::connect(const std::string& host, int port) {
+    return connect_host(host, port);
+}
+
+std::unique_ptr<WinHttpConnection> WinHttpTransport::connect_host(const std::string& host, int port) {
+    if (!hSession) return nullptr;
+    HINTERNET hConnect = WinHttpConnect(hSession, widen(host).c_str(), (INTERNET_PORT)port, 0);
+    if (!hConnect) return nullptr;
+    return std::make_unique<WinHttpConnection>(*this, hConnect, host);
+}
+
+#endif
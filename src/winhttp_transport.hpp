@@ -0,0 +1,92 @@
+#pragma once
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#include <memory>
+#include "transport.hpp"
+#include "cookies.hpp"
+
+// WinHTTP backend. Keep-alive and TLS are handled by WinHTTP itself, cookies and redirects
+// here: WinHTTP's own cookie store cannot be read out, and the session snapshot needs it.
+
+class WinHttpTransport;
+class WinHttpConnection;
+
+class WinHttpRequest : public HttpRequest {
+private:
+    WinHttpTransport& transport;
+    HINTERNET hConnect;                     // Connection of the current hop
+    HINTERNET hRequest;
+    std::unique_ptr<WinHttpConnection> hop; // Set once a redirect moved to another host
+    std::string host, method, path, referer;
+    std::string headers; // Caller's header block, the Cookie line is added for every hop
+    DWORD error = 0;
+    std::wstring wHeaders;   // Converted once at stage time
+    const char* body = nullptr;
+    size_t body_total = 0;
+    size_t sent_upto = 0;
+    bool sent = false;
+    int timeout_ms = 0; // set_timeout() value, reapplied to every hop. 0: WinHTTP defaults
+
+    bool fail();
+    void store_cookies();
+    // Re-issues the request at location, false if it could not be sent
+    bool follow(int status, const std::string& location);
+
+public:
+    WinHttpRequest(WinHttpTransport& transport, HINTERNET connect, HINTERNET request, const std::string& host,
+                   const std::string& method, const std::string& path, const std::string& referer);
+    ~WinHttpRequest();
+
+    bool stage(std::string_view headers, const char* body, size_t total_len) override;
+    bool transmit(size_t upto) override;
+    bool receive() override;
+    int status_code() override;
+    std::string query_header(const std::string& name) override;
+    std::string_view read_body(ResponseBuffer& out) override;
+    std::string url() override;
+    std::string last_error() const override;
+    void set_timeout(int timeout_ms) override;
+    bool timed_out() const override { return error == ERROR_WINHTTP_TIMEOUT; }
+};
+
+class WinHttpConnection : public HttpConnection {
+private:
+    WinHttpTransport& transport;
+    HINTERNET hConnect;
+    std::string host_name;
+
+public:
+    WinHttpConnection(WinHttpTransport& transport, HINTERNET connect, const std::string& host);
+    ~WinHttpConnection();
+
+    std::unique_ptr<HttpRequest> open(const std::string& method, const std::string& path,
+                                      const std::string& referer = "") override;
+    bool preconnect() override;
+    const std::string& host() const override { return host_name; }
+    HINTERNET handle() const { return hConnect; }
+};
+
+class WinHttpTransport : public HttpTransport {
+private:
+    HINTERNET hSession;
+    CookieJar jar;
+
+public:
+    WinHttpTransport(const std::string& user_agent, const TransportOptions& options = {});
+    ~WinHttpTransport();
+
+    std::unique_ptr<HttpConnection> connect(const std::string& host, int port = 443) override;
+    const char* name() const override { return "winhttp"; }
+    CookieJar& cookies() { return jar; }
+    CookieJar* cookie_jar() override { return &jar; }
+
+    // The concrete connection, redirects to another host open one of these
+    std::unique_ptr<WinHttpConnection> connect_host(const std::string& host, int port = 443);
+};
+
+// UTF-8 <-> UTF-16 conversion for the W-suffixed WinHTTP API
+std::wstring widen(std::string_view s);
+std::string narrow(const std::wstring& s);
+
+#endif